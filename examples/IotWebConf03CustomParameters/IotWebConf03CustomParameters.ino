@@ -132,9 +132,9 @@ void handleRoot()
   s += "<li>String param value: ";
   s += stringParamValue;
   s += "<li>Int param value: ";
-  s += atoi(intParamValue);
+  s += intParam.asInt();
   s += "<li>Float param value: ";
-  s += atof(floatParamValue);
+  s += floatParam.asFloat();
   s += "<li>CheckBox selected: ";
 //  s += checkboxParam.isChecked();
   s += "<li>Option selected: ";
@@ -125,7 +125,7 @@ void handleRoot()
     s += "<li>Time server IP: ";
     s += timeServerIp;
     s += "<li>Offset: ";
-    s += atoi(offsetParamValue);
+    s += offsetParam.asInt();
     s += "<li>DST: ";
     s += dstParam.isChecked() ? "ON" : "OFF";
     s += "</ul>";
@@ -87,9 +87,6 @@ void setup()
 
   // -- Initializing the configuration.
   multipleWifiAddition.init();
-  // -- Note: multipleWifiAddition.init() calls setFormValidator, that
-  // overwrites existing formValidator setup. Thus setFormValidator
-  // should be called _after_ multipleWifiAddition.init() .
   iotWebConf.setFormValidator(&formValidator);
   iotWebConf.setHtmlFormatProvider(&optionalGroupHtmlFormatProvider);
   iotWebConf.init();
@@ -156,9 +153,9 @@ void handleRoot()
 bool formValidator(iotwebconf::WebRequestWrapper* webRequestWrapper)
 {
   Serial.println("Validating form.");
-  // -- Note: multipleWifiAddition.formValidator() should be called, as
-  // we have override this setup.
-  bool valid = multipleWifiAddition.formValidator(webRequestWrapper);
+  // -- Note: passwords of the WiFi sets are checked by the constraints
+  // registered in multipleWifiAddition.init().
+  bool valid = true;
 
 /*
   int l = webRequestWrapper->arg(stringParam.getId()).length();
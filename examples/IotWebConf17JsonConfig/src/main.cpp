@@ -21,11 +21,6 @@
 # include <LITTLEFS.h>
 # define LittleFS LITTLEFS
 #endif
-#include <ArduinoJson.h>
-
-#ifndef IOTWEBCONF_ENABLE_JSON
-# error platformio.ini must contain "build_flags = -DIOTWEBCONF_ENABLE_JSON"
-#endif
 
 // -- Initial name of the Thing. Used e.g. as SSID of the own Access Point.
 const char thingName[] = "testThing";
@@ -35,7 +30,6 @@ const char wifiInitialApPassword[] = "smrtTHNG8266";
 
 #define STRING_LEN 128
 #define NUMBER_LEN 32
-#define JSON_FILE_MAX_SIZE 512
 
 // -- Configuration specific key. The value should be modified if config structure was changed.
 #define CONFIG_VERSION "dem2"
@@ -111,6 +105,8 @@ void setup()
   // -- Set up required URL handlers on the web server.
   server.on("/", handleRoot);
   server.on("/config", []{ iotWebConf.handleConfig(); });
+  // -- Current configuration can be downloaded (without passwords).
+  server.on("/config.json", []{ iotWebConf.handleConfigJson(); });
   server.onNotFound([](){ iotWebConf.handleNotFound(); });
 
   Serial.println("Ready.");
@@ -139,9 +135,9 @@ void handleRoot()
   s += "<li>String param value: ";
   s += stringParamValue;
   s += "<li>Int param value: ";
-  s += atoi(intParamValue);
+  s += intParam.asInt();
   s += "<li>Float param value: ";
-  s += atof(floatParamValue);
+  s += floatParam.asFloat();
   s += "<li>CheckBox selected: ";
 //  s += checkboxParam.isChecked();
   s += "<li>Option selected: ";
@@ -181,20 +177,19 @@ void readConfigFile()
   if (configFile)
   {
     Serial.println(F("Reading config file"));
-    StaticJsonDocument<JSON_FILE_MAX_SIZE> doc;
 
-    DeserializationError error = deserializeJson(doc, configFile);
+    // -- Apply JSON configuration, values are applied while reading the file.
+    bool valid = iotWebConf.loadFromJsonStream(&configFile);
     configFile.close();
 
-    if (error)
+    if (!valid)
     {
-      Serial.println(F("Failed to read file, using default configuration"));
+      // -- Some values might be applied already, restore the saved ones.
+      Serial.println(F("Failed to read file, using previous configuration"));
+      iotWebConf.loadConfig();
+      LittleFS.end();
       return;
     }
-    JsonObject documentRoot = doc.as<JsonObject>();
-
-    // -- Apply JSON configuration.
-    iotWebConf.getRootParameterGroup()->loadFromJson(documentRoot);
     iotWebConf.saveConfig();
 
     // -- Remove file after finished loading it.
@@ -12,6 +12,7 @@
 #include <EEPROM.h>
 
 #include "IotWebConf.h"
+#include "IotWebConfJsonReader.h"
 
 #ifdef IOTWEBCONF_CONFIG_USE_MDNS
 # ifdef ESP8266
@@ -23,6 +24,436 @@
 
 #define IOTWEBCONF_STATUS_ENABLED ((this->_statusPin >= 0) && this->_blinkEnabled)
 
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+# define IOTWEBCONF_BOOT_PHASE(PHASE) this->recordBootPhase(PHASE)
+#else
+# define IOTWEBCONF_BOOT_PHASE(PHASE)
+#endif
+
+#if defined(IOTWEBCONF_ENABLE_STATE_TRACE_RTC) && !defined(IOTWEBCONF_ENABLE_STATE_TRACE)
+# error "IOTWEBCONF_ENABLE_STATE_TRACE_RTC requires IOTWEBCONF_ENABLE_STATE_TRACE"
+#endif
+
+#if defined(IOTWEBCONF_ENABLE_WARM_BOOT) || defined(IOTWEBCONF_ENABLE_STATE_TRACE_RTC)
+namespace
+{
+
+uint32_t crc32(const void* buffer, size_t length)
+{
+  const byte* data = (const byte*)buffer;
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (byte b = 0; b < 8; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+} // end anonymous namespace
+#endif
+
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+# define IOTWEBCONF_WARM_BOOT_MAGIC 0x42435749UL
+
+namespace
+{
+
+typedef struct WarmBootSnapshot
+{
+  uint32_t magic;
+  uint32_t checksum; // -- Covers everything after this field.
+  uint16_t size;
+  int16_t channel;
+  uint8_t bssid[6];
+  char configVersion[IOTWEBCONF_CONFIG_VERSION_LENGTH];
+  char ssid[IOTWEBCONF_WORD_LEN];
+  char password[IOTWEBCONF_PASSWORD_LEN];
+  byte data[IOTWEBCONF_WARM_BOOT_DATA_SIZE];
+} WarmBootSnapshot;
+
+# ifdef ESP8266
+static_assert(
+  (IOTWEBCONF_WARM_BOOT_RTC_OFFSET * 4 + sizeof(WarmBootSnapshot)) <= 512,
+  "Warm boot snapshot does not fit into RTC user memory.");
+# elif defined(ESP32)
+RTC_DATA_ATTR WarmBootSnapshot rtcWarmBootSnapshot;
+# endif
+
+void readWarmBootSnapshot(WarmBootSnapshot* snapshot)
+{
+# ifdef ESP8266
+  ESP.rtcUserMemoryRead(
+    IOTWEBCONF_WARM_BOOT_RTC_OFFSET, (uint32_t*)snapshot, sizeof(WarmBootSnapshot));
+# elif defined(ESP32)
+  memcpy(snapshot, &rtcWarmBootSnapshot, sizeof(WarmBootSnapshot));
+# endif
+}
+
+/**
+ * Size of the configuration data in the snapshot, never more than the
+ * data area (size might be garbage in an invalid snapshot).
+ */
+size_t warmBootDataSize(WarmBootSnapshot* snapshot)
+{
+  return snapshot->size > IOTWEBCONF_WARM_BOOT_DATA_SIZE ?
+    IOTWEBCONF_WARM_BOOT_DATA_SIZE : snapshot->size;
+}
+
+void writeWarmBootSnapshot(WarmBootSnapshot* snapshot)
+{
+  // -- Only the used part is written, rounded up to whole blocks.
+  size_t length = offsetof(WarmBootSnapshot, data) + warmBootDataSize(snapshot);
+  length = (length + 3) & ~(size_t)3;
+# ifdef ESP8266
+  ESP.rtcUserMemoryWrite(
+    IOTWEBCONF_WARM_BOOT_RTC_OFFSET, (uint32_t*)snapshot, length);
+# elif defined(ESP32)
+  memcpy(&rtcWarmBootSnapshot, snapshot, length);
+# endif
+}
+
+uint32_t warmBootChecksum(WarmBootSnapshot* snapshot)
+{
+  size_t length = offsetof(WarmBootSnapshot, data) - offsetof(WarmBootSnapshot, size)
+    + warmBootDataSize(snapshot);
+  return crc32(&snapshot->size, length);
+}
+
+} // end anonymous namespace
+#endif
+
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+# define IOTWEBCONF_STATE_TRACE_MAGIC 0x54534957UL
+
+namespace
+{
+
+# ifdef ESP8266
+static_assert(
+  (IOTWEBCONF_STATE_TRACE_RTC_OFFSET * 4 + sizeof(iotwebconf::StateTrace)) <= 512,
+  "State trace does not fit into RTC user memory.");
+#  ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+static_assert(
+  ((IOTWEBCONF_STATE_TRACE_RTC_OFFSET * 4 + sizeof(iotwebconf::StateTrace))
+    <= IOTWEBCONF_WARM_BOOT_RTC_OFFSET * 4) ||
+  ((IOTWEBCONF_WARM_BOOT_RTC_OFFSET * 4 + sizeof(WarmBootSnapshot))
+    <= IOTWEBCONF_STATE_TRACE_RTC_OFFSET * 4),
+  "State trace and warm boot snapshot overlap in RTC user memory.");
+#  endif
+# elif defined(ESP32)
+// -- Not initialized on reset, so the trace survives soft resets.
+RTC_NOINIT_ATTR iotwebconf::StateTrace rtcStateTrace;
+# endif
+
+uint32_t stateTraceChecksum(iotwebconf::StateTrace* trace)
+{
+  return crc32(&trace->head, sizeof(iotwebconf::StateTrace) - offsetof(iotwebconf::StateTrace, head));
+}
+
+} // end anonymous namespace
+#endif
+
+namespace
+{
+
+// -- Connectivity check URLs probed by the operating systems after joining a
+// network (Android, iOS/macOS, Windows, Firefox).
+const char PROBE_ANDROID[] PROGMEM = "/generate_204";
+const char PROBE_ANDROID_SHORT[] PROGMEM = "/gen_204";
+const char PROBE_APPLE[] PROGMEM = "/hotspot-detect.html";
+const char PROBE_APPLE_LEGACY[] PROGMEM = "/library/test/success.html";
+const char PROBE_WINDOWS[] PROGMEM = "/connecttest.txt";
+const char PROBE_WINDOWS_LEGACY[] PROGMEM = "/ncsi.txt";
+const char PROBE_FIREFOX[] PROGMEM = "/success.txt";
+const char PROBE_FIREFOX_CANONICAL[] PROGMEM = "/canonical.html";
+const char* const PROBE_URIS[] = {
+  PROBE_ANDROID, PROBE_ANDROID_SHORT, PROBE_APPLE, PROBE_APPLE_LEGACY,
+  PROBE_WINDOWS, PROBE_WINDOWS_LEGACY, PROBE_FIREFOX, PROBE_FIREFOX_CANONICAL };
+
+bool isProbeUri(const char* uri)
+{
+  for (size_t i = 0; i < sizeof(PROBE_URIS) / sizeof(PROBE_URIS[0]); i++)
+  {
+    if (strcmp_P(uri, PROBE_URIS[i]) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Reads the config item values from the EEPROM, starting at the provided address.
+ */
+class EepromReader : public iotwebconf::Serializer
+{
+public:
+  EepromReader(int start) : _position(start) { }
+  void serialize(iotwebconf::SerializationData* serializationData) override
+  {
+    for (int t = 0; t < serializationData->length; t++)
+    {
+      serializationData->data[t] = EEPROM.read(this->_position++);
+    }
+  }
+
+private:
+  int _position;
+};
+
+/**
+ * Writes the config item values to the EEPROM, starting at the provided address.
+ */
+class EepromWriter : public iotwebconf::Serializer
+{
+public:
+  EepromWriter(int start) : _position(start) { }
+  void serialize(iotwebconf::SerializationData* serializationData) override
+  {
+    for (int t = 0; t < serializationData->length; t++)
+    {
+      EEPROM.write(this->_position++, serializationData->data[t]);
+    }
+  }
+
+private:
+  int _position;
+};
+
+/**
+ * Copies the config item values from or to a memory buffer.
+ */
+class MemorySerializer : public iotwebconf::Serializer
+{
+public:
+  MemorySerializer(byte* buffer, bool write) : _position(buffer), _write(write) { }
+  void serialize(iotwebconf::SerializationData* serializationData) override
+  {
+    if (this->_write)
+    {
+      memcpy(this->_position, serializationData->data, serializationData->length);
+    }
+    else
+    {
+      memcpy(serializationData->data, this->_position, serializationData->length);
+    }
+    this->_position += serializationData->length;
+  }
+
+private:
+  byte* _position;
+  bool _write;
+};
+
+/**
+ * Compares the config item values with the ones in a memory buffer.
+ */
+class CompareSerializer : public iotwebconf::Serializer
+{
+public:
+  CompareSerializer(const byte* buffer) : _position(buffer) { }
+  void serialize(iotwebconf::SerializationData* serializationData) override
+  {
+    if (memcmp(this->_position, serializationData->data, serializationData->length) != 0)
+    {
+      this->_differs = true;
+    }
+    this->_position += serializationData->length;
+  }
+  bool differs() { return this->_differs; }
+
+private:
+  const byte* _position;
+  bool _differs = false;
+};
+
+/**
+ * Applies the values of a streamed JSON config to the items with matching
+ * ids. The nesting of the document is not relevant, the ids are looked up in
+ * the item index. Keys not known by the index (e.g. the active flag of an
+ * OptionalParameterGroup) are offered to the item of the enclosing object.
+ */
+class ConfigJsonHandler : public iotwebconf::JsonStreamHandler
+{
+public:
+  ConfigJsonHandler(iotwebconf::IotWebConf* iotWebConf) :
+    _iotWebConf(iotWebConf) { }
+  void beginObject(const char* key) override
+  {
+    if (this->_depth < IOTWEBCONF_JSON_MAX_DEPTH)
+    {
+      this->_objectItems[this->_depth] =
+        key == nullptr ? nullptr : this->_iotWebConf->findItem(key);
+    }
+    this->_depth++;
+  }
+  void endObject() override
+  {
+    this->_depth--;
+  }
+  void value(const char* key, const String& value) override
+  {
+    if (key == nullptr)
+    {
+      // -- Array elements are not applied.
+      return;
+    }
+    if (this->_iotWebConf->applyValue(key, value))
+    {
+      return;
+    }
+    iotwebconf::ConfigItem* enclosing = this->_iotWebConf->getRootParameterGroup();
+    for (int i = this->_depth - 1; i >= 0; i--)
+    {
+      if ((i < IOTWEBCONF_JSON_MAX_DEPTH) && (this->_objectItems[i] != nullptr))
+      {
+        enclosing = this->_objectItems[i];
+        break;
+      }
+    }
+    if (!enclosing->loadJsonValue(key, value))
+    {
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+      Serial.print(F("No item found for JSON key: "));
+      Serial.println(key);
+#endif
+    }
+  }
+
+private:
+  iotwebconf::IotWebConf* _iotWebConf;
+  iotwebconf::ConfigItem* _objectItems[IOTWEBCONF_JSON_MAX_DEPTH];
+  int _depth = 0;
+};
+
+/**
+ * Answers the form arguments of the config items from their positions in
+ * the request, collected once via the item index. So every parameter finds
+ * its argument with a binary search, instead of comparing the names of all
+ * the arguments. Other arguments are queried from the wrapped request.
+ */
+class IndexedFormRequest : public iotwebconf::WebRequestWrapper
+{
+public:
+  IndexedFormRequest(
+    iotwebconf::WebRequestWrapper* request, iotwebconf::ItemIndex* index) :
+    _request(request), _index(index)
+  {
+    int count = request->args();
+    this->_indexed = index->isBuilt() && (count >= 0);
+    if (!this->_indexed)
+    {
+      return;
+    }
+    for (int i = 0; i < index->getCount(); i++)
+    {
+      this->_positions[i] = -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+      int position = index->indexOf(request->argName(i).c_str());
+      if ((position >= 0) && (this->_positions[position] < 0))
+      {
+        this->_positions[position] = i;
+      }
+    }
+  }
+
+  const String hostHeader() const override { return this->_request->hostHeader(); }
+  IPAddress localIP() override { return this->_request->localIP(); }
+  uint16_t localPort() override { return this->_request->localPort(); }
+  const String uri() const override { return this->_request->uri(); }
+  bool authenticate(const char * username, const char * password) override
+    { return this->_request->authenticate(username, password); }
+  void requestAuthentication() override { this->_request->requestAuthentication(); }
+  bool hasArg(const String& name) override
+  {
+    int position = this->positionOf(name);
+    return position == -2 ?
+      this->_request->hasArg(name) : position >= 0;
+  }
+  String arg(const String name) override
+  {
+    int position = this->positionOf(name);
+    if (position == -2)
+    {
+      return this->_request->arg(name);
+    }
+    return position >= 0 ? this->_request->arg(position) : String();
+  }
+  int args() override { return this->_request->args(); }
+  String argName(int i) override { return this->_request->argName(i); }
+  String arg(int i) override { return this->_request->arg(i); }
+  void sendHeader(const String& name, const String& value, bool first = false) override
+    { this->_request->sendHeader(name, value, first); }
+  void setContentLength(const size_t contentLength) override
+    { this->_request->setContentLength(contentLength); }
+  void send(int code, const char* content_type = nullptr, const String& content = String("")) override
+    { this->_request->send(code, content_type, content); }
+  void sendContent(const String& content) override { this->_request->sendContent(content); }
+  void stop() override { this->_request->stop(); }
+
+private:
+  iotwebconf::WebRequestWrapper* _request;
+  iotwebconf::ItemIndex* _index;
+  bool _indexed;
+  int16_t _positions[IOTWEBCONF_ITEM_INDEX_SIZE];
+
+  /**
+   * Position of the argument, -1 if an indexed id was not posted, -2 if the
+   *   name is not indexed.
+   */
+  int positionOf(const String& name)
+  {
+    if (!this->_indexed)
+    {
+      return -2;
+    }
+    int position = this->_index->indexOf(name.c_str());
+    return position < 0 ? -2 : this->_positions[position];
+  }
+};
+
+/**
+ * Collects the output in a small buffer, and sends it as a chunk of the
+ * response whenever the buffer is full.
+ */
+class WebRequestPrint : public Print
+{
+public:
+  WebRequestPrint(iotwebconf::WebRequestWrapper* webRequestWrapper) :
+    _webRequestWrapper(webRequestWrapper) { }
+  size_t write(uint8_t c) override
+  {
+    this->_buffer[this->_length++] = c;
+    if (this->_length == sizeof(this->_buffer) - 1)
+    {
+      this->sendBuffer();
+    }
+    return 1;
+  }
+  void sendBuffer()
+  {
+    if (this->_length > 0)
+    {
+      this->_buffer[this->_length] = '\0';
+      this->_webRequestWrapper->sendContent(String(this->_buffer));
+      this->_length = 0;
+    }
+  }
+
+private:
+  iotwebconf::WebRequestWrapper* _webRequestWrapper;
+  char _buffer[128];
+  size_t _length = 0;
+};
+
+} // end anonymous namespace
+
 ////////////////////////////////////////////////////////////////
 
 namespace iotwebconf
@@ -39,6 +470,9 @@ IotWebConf::IotWebConf(
   this->_configVersion = configVersion;
 
   this->_apTimeoutParameter.visible = false;
+  this->addConstraint(&this->_thingNameConstraint);
+  this->addConstraint(&this->_apPasswordConstraint);
+  this->addConstraint(&this->_wifiPasswordConstraint);
   this->_systemParameters.addItem(&this->_thingNameParameter);
   this->_systemParameters.addItem(&this->_apPasswordParameter);
   this->_systemParameters.addItem(&this->_wifiParameters);
@@ -69,6 +503,7 @@ void IotWebConf::setStatusPin(int statusPin, int statusOnLevel)
 
 bool IotWebConf::init()
 {
+  IOTWEBCONF_BOOT_PHASE(BootPhaseInitStart);
   // -- Setup pins.
   if (this->_configPin >= 0)
   {
@@ -80,9 +515,18 @@ bool IotWebConf::init()
     pinMode(this->_statusPin, OUTPUT);
     digitalWrite(this->_statusPin, !this->_statusOnLevel);
   }
+  IOTWEBCONF_BOOT_PHASE(BootPhasePinsReady);
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+  this->loadStateTrace();
+#endif
 
-  // -- Load configuration from EEPROM.
+  // -- Load configuration from EEPROM (or from RTC memory after deep sleep).
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+  this->_warmBoot = this->loadWarmBootSnapshot();
+  bool validConfig = this->_warmBoot || this->loadConfig();
+#else
   bool validConfig = this->loadConfig();
+#endif
   if (!validConfig)
   {
     // -- No config
@@ -90,7 +534,19 @@ bool IotWebConf::init()
     this->_wifiParameters._wifiSsid[0] = '\0';
     this->_wifiParameters._wifiPassword[0] = '\0';
   }
-  this->_apTimeoutMs = atoi(this->_apTimeoutStr) * 1000;
+  this->_apTimeoutMs = this->_apTimeoutParameter.asInt() * 1000;
+  if (!this->_itemIndex.build(&this->_allParameters))
+  {
+    IOTWEBCONF_DEBUG_LINE(
+      F("Item index is full, increase IOTWEBCONF_ITEM_INDEX_SIZE."));
+  }
+  ChangeListener* listener = this->_firstChangeListener;
+  while (listener != nullptr)
+  {
+    this->snapshotChangeListener(listener);
+    listener = listener->_nextListener;
+  }
+  IOTWEBCONF_BOOT_PHASE(BootPhaseInitDone);
 
   return validConfig;
 }
@@ -112,6 +568,88 @@ void IotWebConf::addSystemParameter(ConfigItem* parameter)
   this->_systemParameters.addItem(parameter);
 }
 
+ConfigItem* IotWebConf::findItem(const char* id)
+{
+  if (!this->_itemIndex.isBuilt())
+  {
+    return this->_allParameters.findItem(id);
+  }
+  int position = this->_itemIndex.indexOf(id);
+  return position < 0 ? nullptr : this->_itemIndex.getItem(position);
+}
+
+bool IotWebConf::applyValue(const char* id, const String& value)
+{
+  ConfigItem* item = this->findItem(id);
+  if ((item == nullptr) || !item->loadJsonValue(id, value))
+  {
+    return false;
+  }
+  ConfigItem* child = item;
+  while (child->_parentItem != nullptr)
+  {
+    ParameterGroup* parent = static_cast<ParameterGroup*>(child->_parentItem);
+    parent->valueApplied(child);
+    child = parent;
+  }
+  return true;
+}
+
+void IotWebConf::writeJson(Print* out, JsonPasswordPolicy passwordPolicy)
+{
+  JsonWriter writer(out, passwordPolicy);
+  writer.beginObject(nullptr);
+  this->_allParameters.writeJson(&writer);
+  writer.endObject();
+}
+
+void IotWebConf::handleConfigJson(
+  WebRequestWrapper* webRequestWrapper, JsonPasswordPolicy passwordPolicy)
+{
+  if (!webRequestWrapper->authenticate(
+          IOTWEBCONF_ADMIN_USER_NAME, this->_apPassword))
+  {
+    IOTWEBCONF_DEBUG_LINE(F("Requesting authentication."));
+    webRequestWrapper->requestAuthentication();
+    return;
+  }
+  IOTWEBCONF_DEBUG_LINE(F("Config export requested."));
+
+  webRequestWrapper->sendHeader(
+      "Cache-Control", "no-cache, no-store, must-revalidate");
+  webRequestWrapper->sendHeader("Pragma", "no-cache");
+  webRequestWrapper->sendHeader("Expires", "-1");
+  webRequestWrapper->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  webRequestWrapper->send(200, "application/json", "");
+
+  WebRequestPrint out(webRequestWrapper);
+  this->writeJson(&out, passwordPolicy);
+  out.sendBuffer();
+  webRequestWrapper->sendContent(F(""));
+  webRequestWrapper->stop();
+}
+
+bool IotWebConf::loadFromJsonStream(Stream* in)
+{
+  ConfigJsonHandler handler(this);
+  JsonStreamReader reader(in);
+  bool valid = reader.read(&handler);
+  if (!valid)
+  {
+    IOTWEBCONF_DEBUG_LINE(F("Invalid JSON config."));
+  }
+  return valid;
+}
+
+void IotWebConf::memoryReportTo(Stream* out)
+{
+  size_t ram = this->_allParameters.memoryReportTo(out);
+  out->print(F("Total RAM: "));
+  out->print(ram);
+  out->print(F(", EEPROM: "));
+  out->println(this->_allParameters.getStorageSize());
+}
+
 int IotWebConf::initConfig()
 {
   int size = this->_allParameters.getStorageSize();
@@ -131,36 +669,64 @@ int IotWebConf::initConfig()
 bool IotWebConf::loadConfig()
 {
   int size = this->initConfig();
+  if (this->_legacyConfigVersion != nullptr)
+  {
+    // -- The legacy layout might need more space.
+    this->_legacyLayoutHandler(true);
+    int legacySize = this->_allParameters.getStorageSize();
+    this->_legacyLayoutHandler(false);
+    size = legacySize > size ? legacySize : size;
+  }
+  IOTWEBCONF_BOOT_PHASE(BootPhaseConfigSized);
   EEPROM.begin(
     IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH + size);
+  IOTWEBCONF_BOOT_PHASE(BootPhaseEepromOpened);
 
   bool result;
-  if (this->testConfigVersion())
+  bool legacy =
+    (this->_legacyConfigVersion != nullptr) &&
+    !this->testConfigVersion(this->_configVersion) &&
+    this->testConfigVersion(this->_legacyConfigVersion);
+  if (legacy || this->testConfigVersion(this->_configVersion))
   {
-    int start = IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH;
     IOTWEBCONF_DEBUG_LINE(F("Loading configurations"));
-    this->_allParameters.loadValue([&](SerializationData* serializationData)
+    EepromReader reader(IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH);
+    if (legacy)
+    {
+      IOTWEBCONF_DEBUG_LINE(F("Legacy config version, migrating layout."));
+      this->_legacyLayoutHandler(true);
+      this->_allParameters.loadValueFrom(reader);
+      this->_legacyLayoutHandler(false);
+    }
+    else
     {
-        this->readEepromValue(start, serializationData->data, serializationData->length);
-        start += serializationData->length;
-    });
+      this->_allParameters.loadValueFrom(reader);
+    }
+    IOTWEBCONF_BOOT_PHASE(BootPhaseValuesLoaded);
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
     this->_allParameters.debugTo(&Serial);
 #endif
+    IOTWEBCONF_BOOT_PHASE(BootPhaseConfigDumped);
     result = true;
   }
   else
   {
     IOTWEBCONF_DEBUG_LINE(F("Wrong config version. Applying defaults."));
     this->_allParameters.applyDefaultValue();
+    IOTWEBCONF_BOOT_PHASE(BootPhaseValuesLoaded);
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
     this->_allParameters.debugTo(&Serial);
 #endif
+    IOTWEBCONF_BOOT_PHASE(BootPhaseConfigDumped);
 
     result = false;
   }
 
   EEPROM.end();
+  if (legacy)
+  {
+    this->saveConfig();
+  }
   return result;
 }
 
@@ -175,21 +741,22 @@ void IotWebConf::saveConfig()
     IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH + size);
 
   this->saveConfigVersion();
-  int start = IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH;
   IOTWEBCONF_DEBUG_LINE(F("Saving configuration"));
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
   this->_allParameters.debugTo(&Serial);
   Serial.println();
 #endif
-  this->_allParameters.storeValue([&](SerializationData* serializationData)
-  {
-    this->writeEepromValue(start, serializationData->data, serializationData->length);
-    start += serializationData->length;
-  });
+  EepromWriter writer(IOTWEBCONF_CONFIG_START + IOTWEBCONF_CONFIG_VERSION_LENGTH);
+  this->_allParameters.storeValueTo(writer);
 
   EEPROM.end();
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+  this->invalidateWarmBootSnapshot();
+#endif
 
-  this->_apTimeoutMs = atoi(this->_apTimeoutStr) * 1000;
+  this->_apTimeoutMs = this->_apTimeoutParameter.asInt() * 1000;
+
+  this->notifyChangeListeners();
 
   if (this->_configSavedCallback != nullptr)
   {
@@ -197,26 +764,79 @@ void IotWebConf::saveConfig()
   }
 }
 
-void IotWebConf::readEepromValue(int start, byte* valueBuffer, int length)
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+/**
+ * Restore configuration and last connection info from RTC memory.
+ */
+bool IotWebConf::loadWarmBootSnapshot()
 {
-  for (int t = 0; t < length; t++)
+  WarmBootSnapshot snapshot;
+  readWarmBootSnapshot(&snapshot);
+  int size = this->_allParameters.getStorageSize();
+  if ((snapshot.magic != IOTWEBCONF_WARM_BOOT_MAGIC) ||
+    (snapshot.size != size) ||
+    (size > IOTWEBCONF_WARM_BOOT_DATA_SIZE) ||
+    (strncmp(snapshot.configVersion, this->_configVersion, IOTWEBCONF_CONFIG_VERSION_LENGTH) != 0) ||
+    (snapshot.checksum != warmBootChecksum(&snapshot)))
   {
-    *((char*)valueBuffer + t) = EEPROM.read(start + t);
+    return false;
   }
+
+  MemorySerializer reader(snapshot.data, false);
+  this->_allParameters.loadValueFrom(reader);
+  strncpy(this->_warmBootSsid, snapshot.ssid, IOTWEBCONF_WORD_LEN);
+  strncpy(this->_warmBootPassword, snapshot.password, IOTWEBCONF_PASSWORD_LEN);
+  memcpy(this->_directedBssid, snapshot.bssid, 6);
+  this->_directedChannel = snapshot.channel;
+  IOTWEBCONF_DEBUG_LINE(F("Configuration restored from RTC memory."));
+  return true;
 }
-void IotWebConf::writeEepromValue(int start, byte* valueBuffer, int length)
+
+/**
+ * Keep configuration and current connection info in RTC memory.
+ */
+void IotWebConf::saveWarmBootSnapshot()
 {
-  for (int t = 0; t < length; t++)
+  int size = this->_allParameters.getStorageSize();
+  if (size > IOTWEBCONF_WARM_BOOT_DATA_SIZE)
+  {
+    IOTWEBCONF_DEBUG_LINE(F("Configuration is too large for warm boot."));
+    return;
+  }
+
+  WarmBootSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(WarmBootSnapshot));
+  snapshot.magic = IOTWEBCONF_WARM_BOOT_MAGIC;
+  snapshot.size = size;
+  snapshot.channel = WiFi.channel();
+  uint8_t* bssid = WiFi.BSSID();
+  if (bssid != nullptr)
   {
-    EEPROM.write(start + t, *((char*)valueBuffer + t));
+    memcpy(snapshot.bssid, bssid, 6);
   }
+  strncpy(snapshot.configVersion, this->_configVersion, IOTWEBCONF_CONFIG_VERSION_LENGTH);
+  strncpy(snapshot.ssid, this->_wifiAuthInfo.ssid, IOTWEBCONF_WORD_LEN - 1);
+  strncpy(snapshot.password, this->_wifiAuthInfo.password, IOTWEBCONF_PASSWORD_LEN - 1);
+  MemorySerializer writer(snapshot.data, true);
+  this->_allParameters.storeValueTo(writer);
+  snapshot.checksum = warmBootChecksum(&snapshot);
+  writeWarmBootSnapshot(&snapshot);
 }
 
-bool IotWebConf::testConfigVersion()
+void IotWebConf::invalidateWarmBootSnapshot()
+{
+  WarmBootSnapshot snapshot;
+  readWarmBootSnapshot(&snapshot);
+  snapshot.magic = 0;
+  writeWarmBootSnapshot(&snapshot);
+}
+#endif
+
+bool IotWebConf::testConfigVersion(const char* configVersion)
 {
   for (byte t = 0; t < IOTWEBCONF_CONFIG_VERSION_LENGTH; t++)
   {
-    if (EEPROM.read(IOTWEBCONF_CONFIG_START + t) != this->_configVersion[t])
+    if (EEPROM.read(IOTWEBCONF_CONFIG_START + t) != configVersion[t])
     {
       return false;
     }
@@ -228,23 +848,102 @@ void IotWebConf::saveConfigVersion()
 {
   for (byte t = 0; t < IOTWEBCONF_CONFIG_VERSION_LENGTH; t++)
   {
-    EEPROM.write(IOTWEBCONF_CONFIG_START + t, this->_configVersion[t]);
+    EEPROM.write(IOTWEBCONF_CONFIG_START + t, this->_configVersion[t]);
+  }
+}
+
+void IotWebConf::setLegacyConfigVersion(
+  const char* legacyConfigVersion, std::function<void(bool legacy)> layoutHandler)
+{
+  this->_legacyConfigVersion = legacyConfigVersion;
+  this->_legacyLayoutHandler = layoutHandler;
+}
+
+void IotWebConf::setWifiConnectionCallback(std::function<void()> func)
+{
+  this->_wifiConnectionCallback = func;
+}
+
+void IotWebConf::setConfigSavingCallback(std::function<void(int size)> func)
+{
+  this->_configSavingCallback = func;
+}
+
+void IotWebConf::setConfigSavedCallback(std::function<void()> func)
+{
+  this->_configSavedCallback = func;
+}
+
+void IotWebConf::addChangeListener(ChangeListener* listener)
+{
+  this->snapshotChangeListener(listener);
+  if (this->_firstChangeListener == nullptr)
+  {
+    this->_firstChangeListener = listener;
+    return;
+  }
+  ChangeListener* current = this->_firstChangeListener;
+  while (current->_nextListener != nullptr)
+  {
+    current = current->_nextListener;
   }
+  current->_nextListener = listener;
 }
 
-void IotWebConf::setWifiConnectionCallback(std::function<void()> func)
+void IotWebConf::snapshotChangeListener(ChangeListener* listener)
 {
-  this->_wifiConnectionCallback = func;
+  int size = listener->_item->getStorageSize();
+  if (size != listener->_snapshotSize)
+  {
+    // -- Only happens on registration (or when items were added to the
+    // observed group after that).
+    delete[] listener->_snapshot;
+    listener->_snapshot = new byte[size];
+    listener->_snapshotSize = size;
+  }
+  MemorySerializer writer(listener->_snapshot, true);
+  listener->_item->storeValueTo(writer);
 }
 
-void IotWebConf::setConfigSavingCallback(std::function<void(int size)> func)
+void IotWebConf::notifyChangeListeners()
 {
-  this->_configSavingCallback = func;
+  ChangeListener* listener = this->_firstChangeListener;
+  while (listener != nullptr)
+  {
+    int size = listener->_item->getStorageSize();
+    if (size != listener->_snapshotSize)
+    {
+      // -- Structure of the item changed, values are not comparable.
+      this->snapshotChangeListener(listener);
+    }
+    else
+    {
+      // -- Values are compared while streaming, nothing is copied.
+      CompareSerializer comparer(listener->_snapshot);
+      listener->_item->storeValueTo(comparer);
+      if (comparer.differs())
+      {
+        this->snapshotChangeListener(listener);
+        listener->_onChange(listener->_item);
+      }
+    }
+    listener = listener->_nextListener;
+  }
 }
 
-void IotWebConf::setConfigSavedCallback(std::function<void()> func)
+void IotWebConf::addConstraint(Constraint* constraint)
 {
-  this->_configSavedCallback = func;
+  if (this->_firstConstraint == nullptr)
+  {
+    this->_firstConstraint = constraint;
+    return;
+  }
+  Constraint* current = this->_firstConstraint;
+  while (current->_nextConstraint != nullptr)
+  {
+    current = current->_nextConstraint;
+  }
+  current->_nextConstraint = constraint;
 }
 
 void IotWebConf::setFormValidator(
@@ -260,8 +959,10 @@ void IotWebConf::setWifiConnectionTimeoutMs(unsigned long millis)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void IotWebConf::handleConfig(WebRequestWrapper* webRequestWrapper)
+void IotWebConf::handleConfig(WebRequestWrapper* request)
 {
+  IndexedFormRequest indexedRequest(request, &this->_itemIndex);
+  WebRequestWrapper* webRequestWrapper = &indexedRequest;
   if (this->_state == OnLine)
   {
     // -- Authenticate
@@ -391,26 +1092,35 @@ bool IotWebConf::validateForm(WebRequestWrapper* webRequestWrapper)
     valid = this->_formValidator(webRequestWrapper);
   }
 
-  // -- Internal validation.
-  int l = webRequestWrapper->arg(this->_thingNameParameter.getId()).length();
-  if (3 > l)
-  {
-    this->_thingNameParameter.errorMessage =
-        "Give a name with at least 3 characters.";
-    valid = false;
-  }
-  l = webRequestWrapper->arg(this->_apPasswordParameter.getId()).length();
-  if ((0 < l) && (l < 8))
+  // -- Check all constraints in a single pass, each argument is fetched once.
+  FormSnapshot::Entry entries[IOTWEBCONF_FORM_SNAPSHOT_SIZE];
+  FormSnapshot form(webRequestWrapper, entries, IOTWEBCONF_FORM_SNAPSHOT_SIZE);
+  Constraint* constraint = this->_firstConstraint;
+  while (constraint != nullptr)
   {
-    this->_apPasswordParameter.errorMessage =
-        "Password length must be at least 8 characters.";
-    valid = false;
+    FormSnapshot::Entry* entry = form.find(constraint->getId());
+    if (entry == nullptr)
+    {
+      // -- No room for the value, the constraint cannot be checked.
+      constraint->getItem()->setFieldErrorMessage(
+        constraint->getId(), constraint->getErrorMessage());
+      valid = false;
+    }
+    else if (!entry->failed && !constraint->check(&form))
+    {
+      // -- Only the first error of an item is reported.
+      entry->failed = true;
+      constraint->getItem()->setFieldErrorMessage(
+        constraint->getId(), constraint->getErrorMessage());
+      valid = false;
+    }
+    constraint = constraint->_nextConstraint;
   }
-  l = webRequestWrapper->arg(this->_wifiParameters.wifiPasswordParameter.getId()).length();
-  if ((0 < l) && (l < 8))
+
+  if (form.isOverflowed())
   {
-    this->_wifiParameters.wifiPasswordParameter.errorMessage =
-        "Password length must be at least 8 characters.";
+    IOTWEBCONF_DEBUG_LINE(
+      F("Form snapshot is full, increase IOTWEBCONF_FORM_SNAPSHOT_SIZE."));
     valid = false;
   }
 
@@ -447,6 +1157,47 @@ void IotWebConf::handleNotFound(WebRequestWrapper* webRequestWrapper)
   webRequestWrapper->send(404, "text/plain", message);
 }
 
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+const char* IotWebConf::getBootPhaseName(BootPhase phase)
+{
+  static const char* const names[BootPhaseCount] = {
+    "initStart", "pinsReady", "configSized", "eepromOpened", "valuesLoaded",
+    "configDumped", "initDone", "firstState", "connecting", "onLine" };
+  return phase < BootPhaseCount ? names[phase] : "";
+}
+
+void IotWebConf::handleBootProfile(WebRequestWrapper* webRequestWrapper)
+{
+  IOTWEBCONF_DEBUG_LINE(F("Boot profile requested."));
+  // -- One line per phase: name, micros() timestamp, time since previous phase.
+  String message;
+  unsigned long previous = this->_bootPhaseMicros[BootPhaseInitStart];
+  for (int i = 0; i < BootPhaseCount; i++)
+  {
+    unsigned long timestamp = this->_bootPhaseMicros[i];
+    message += getBootPhaseName((BootPhase)i);
+    message += " ";
+    if (timestamp == 0)
+    {
+      message += "-\n";
+      continue;
+    }
+    message += String(timestamp);
+    message += " +";
+    message += String(timestamp - previous);
+    message += "\n";
+    previous = timestamp;
+  }
+
+  webRequestWrapper->sendHeader(
+      "Cache-Control", "no-cache, no-store, must-revalidate");
+  webRequestWrapper->sendHeader("Pragma", "no-cache");
+  webRequestWrapper->sendHeader("Expires", "-1");
+  webRequestWrapper->sendHeader("Content-Length", String(message.length()));
+  webRequestWrapper->send(200, "text/plain", message);
+}
+#endif
+
 /**
  * Redirect to captive portal if we got a request for another domain.
  * Return true in that case so the page handler do not try to handle the request
@@ -459,6 +1210,22 @@ bool IotWebConf::handleCaptivePortal(WebRequestWrapper* webRequestWrapper)
   thingName.toLowerCase();
   if (!isIp(host) && !host.startsWith(thingName))
   {
+    if (isProbeUri(webRequestWrapper->uri().c_str()))
+    {
+      // -- Fast path for connectivity checks: the sooner the redirect is
+      // served, the sooner the captive portal sheet pops up.
+      if (this->_captivePortalLocation[0] == '\0')
+      {
+        IPAddress ip = webRequestWrapper->localIP();
+        snprintf(this->_captivePortalLocation, sizeof(this->_captivePortalLocation),
+          "http://%d.%d.%d.%d:%u/", ip[0], ip[1], ip[2], ip[3],
+          webRequestWrapper->localPort());
+      }
+      webRequestWrapper->sendHeader("Location", this->_captivePortalLocation, true);
+      webRequestWrapper->setContentLength(0);
+      webRequestWrapper->send(302, "text/plain", "");
+      return true;
+    }
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
     Serial.print("Request for ");
     Serial.print(host);
@@ -528,7 +1295,7 @@ void IotWebConf::doLoop()
     {
       startupState = OffLine;
     }
-    else if (this->_skipApStartup)
+    else if (this->_skipApStartup || this->_warmBoot)
     {
       if (mustStayInApMode())
       {
@@ -541,9 +1308,18 @@ void IotWebConf::doLoop()
         // -- Startup state can be WiFi, if it is requested and also possible.
         IOTWEBCONF_DEBUG_LINE(F("SkipApStartup mode was applied"));
         startupState = Connecting;
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+        if (this->_warmBoot && (this->_directedChannel > 0))
+        {
+          // -- Reconnect to the access point used before deep sleep.
+          this->_directedFallbackAuthInfo = this->_wifiAuthInfo;
+          this->_wifiAuthInfo = { this->_warmBootSsid, this->_warmBootPassword };
+          this->_directedConnection = true;
+        }
+#endif
       }
     }
-    this->changeState(startupState);
+    this->changeState(startupState, CauseBoot);
   }
   else if (
       (this->_state == NotConfigured) ||
@@ -554,14 +1330,25 @@ void IotWebConf::doLoop()
     // connecting to WiFi
     checkConnection();
     checkApTimeout();
-    this->_dnsServer->processNextRequest();
+    this->processDns();
     this->_webServerWrapper->handleClient();
   }
   else if (this->_state == Connecting)
   {
+    if (this->_apActive)
+    {
+      // -- AP+STA mode, keep serving the config portal while connecting.
+      this->processDns();
+      this->_webServerWrapper->handleClient();
+    }
+    if (this->_wifiScanInProgress)
+    {
+      checkWifiScan();
+      return;
+    }
     if (checkWifiConnection())
     {
-      this->changeState(OnLine);
+      this->changeState(OnLine, CauseConnected);
       return;
     }
   }
@@ -579,16 +1366,28 @@ void IotWebConf::doLoop()
     if (WiFi.status() != WL_CONNECTED)
     {
       IOTWEBCONF_DEBUG_LINE(F("Not connected. Try reconnect..."));
-      this->changeState(Connecting);
+      this->changeState(Connecting, CauseWifiLost);
       return;
     }
+    if (this->_apActive)
+    {
+      checkApShutdown();
+    }
+    else if (this->_roamingPolicy != nullptr)
+    {
+      checkRoaming();
+    }
+    if (this->_updateClientLoopFunction != nullptr)
+    {
+      this->_updateClientLoopFunction();
+    }
   }
 }
 
 /**
  * What happens, when a state changed...
  */
-void IotWebConf::changeState(NetworkState newState)
+void IotWebConf::changeState(NetworkState newState, TransitionCause cause)
 {
   switch (newState)
   {
@@ -623,7 +1422,21 @@ void IotWebConf::changeState(NetworkState newState)
 #endif
   NetworkState oldState = this->_state;
   this->_state = newState;
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+  this->recordStateTransition(oldState, newState, cause);
+#endif
   this->stateChanged(oldState, newState);
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+  this->recordBootPhase(BootPhaseFirstState);
+  if (newState == Connecting)
+  {
+    this->recordBootPhase(BootPhaseConnecting);
+  }
+  else if (newState == OnLine)
+  {
+    this->recordBootPhase(BootPhaseOnLine);
+  }
+#endif
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
   Serial.print("State changed from: ");
   Serial.print(oldState);
@@ -632,6 +1445,128 @@ void IotWebConf::changeState(NetworkState newState)
 #endif
 }
 
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+void IotWebConf::recordStateTransition(
+  NetworkState oldState, NetworkState newState, TransitionCause cause)
+{
+  StateTransition* record = &this->_stateTrace.records[this->_stateTrace.head];
+  record->timeMs = millis();
+  record->oldState = oldState;
+  record->newState = newState;
+  record->cause = cause;
+  const char* ssid = this->_wifiAuthInfo.ssid != nullptr ? this->_wifiAuthInfo.ssid : "";
+  strncpy(record->ssid, ssid, IOTWEBCONF_STATE_TRACE_SSID_LEN - 1);
+  record->ssid[IOTWEBCONF_STATE_TRACE_SSID_LEN - 1] = '\0';
+
+  this->_stateTrace.head = (this->_stateTrace.head + 1) % IOTWEBCONF_STATE_TRACE_SIZE;
+  if (this->_stateTrace.count < IOTWEBCONF_STATE_TRACE_SIZE)
+  {
+    this->_stateTrace.count++;
+  }
+# ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+  this->persistStateTrace();
+# endif
+}
+
+const StateTransition* IotWebConf::getStateTransition(int index)
+{
+  if ((index < 0) || (index >= this->_stateTrace.count))
+  {
+    return nullptr;
+  }
+  int position =
+    (this->_stateTrace.head + IOTWEBCONF_STATE_TRACE_SIZE - 1 - index) %
+    IOTWEBCONF_STATE_TRACE_SIZE;
+  return &this->_stateTrace.records[position];
+}
+
+void IotWebConf::clearStateTrace()
+{
+  this->_stateTrace.head = 0;
+  this->_stateTrace.count = 0;
+# ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+  this->persistStateTrace();
+# endif
+}
+
+void IotWebConf::handleStateTrace(WebRequestWrapper* webRequestWrapper)
+{
+  IOTWEBCONF_DEBUG_LINE(F("State trace requested."));
+  String message = "[";
+  for (int i = this->_stateTrace.count - 1; i >= 0; i--)
+  {
+    const StateTransition* record = this->getStateTransition(i);
+    message += "[";
+    message += String(record->timeMs);
+    message += ",";
+    message += String(record->oldState);
+    message += ",";
+    message += String(record->newState);
+    message += ",";
+    message += String(record->cause);
+    message += ",\"";
+    for (const char* c = record->ssid; *c != '\0'; c++)
+    {
+      if ((*c == '"') || (*c == '\\'))
+      {
+        message += '\\';
+      }
+      message += *c;
+    }
+    message += i > 0 ? "\"]," : "\"]";
+  }
+  message += "]";
+
+  webRequestWrapper->sendHeader(
+      "Cache-Control", "no-cache, no-store, must-revalidate");
+  webRequestWrapper->sendHeader("Pragma", "no-cache");
+  webRequestWrapper->sendHeader("Expires", "-1");
+  webRequestWrapper->sendHeader("Content-Length", String(message.length()));
+  webRequestWrapper->send(200, "application/json", message);
+}
+
+# ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+/**
+ * Restore the state trace kept in RTC memory before a soft reset.
+ */
+void IotWebConf::loadStateTrace()
+{
+  StateTrace trace;
+#  ifdef ESP8266
+  ESP.rtcUserMemoryRead(
+    IOTWEBCONF_STATE_TRACE_RTC_OFFSET, (uint32_t*)&trace, sizeof(StateTrace));
+#  elif defined(ESP32)
+  memcpy(&trace, &rtcStateTrace, sizeof(StateTrace));
+#  endif
+  if ((trace.magic != IOTWEBCONF_STATE_TRACE_MAGIC) ||
+    (trace.checksum != stateTraceChecksum(&trace)) ||
+    (trace.head >= IOTWEBCONF_STATE_TRACE_SIZE) ||
+    (trace.count > IOTWEBCONF_STATE_TRACE_SIZE))
+  {
+    IOTWEBCONF_DEBUG_LINE(F("No state trace in RTC memory."));
+    return;
+  }
+  this->_stateTrace = trace;
+#  ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+  Serial.print(F("State changes restored from RTC memory: "));
+  Serial.println(this->_stateTrace.count);
+#  endif
+}
+
+void IotWebConf::persistStateTrace()
+{
+  this->_stateTrace.magic = IOTWEBCONF_STATE_TRACE_MAGIC;
+  this->_stateTrace.checksum = stateTraceChecksum(&this->_stateTrace);
+#  ifdef ESP8266
+  ESP.rtcUserMemoryWrite(
+    IOTWEBCONF_STATE_TRACE_RTC_OFFSET, (uint32_t*)&this->_stateTrace, sizeof(StateTrace));
+#  elif defined(ESP32)
+  memcpy(&rtcStateTrace, &this->_stateTrace, sizeof(StateTrace));
+#  endif
+}
+# endif
+#endif
+
 /**
  * Cleanly stopping mDNS after network failure.
  */
@@ -652,11 +1587,22 @@ void IotWebConf::endMDns(NetworkState oldState)
 void IotWebConf::stateChanged(NetworkState oldState, NetworkState newState)
 {
 //  updateOutput();
+  if (this->_wifiScanInProgress || this->_roamingScanInProgress)
+  {
+    // -- State was changed externally while scanning.
+    WiFi.scanDelete();
+    this->_wifiScanInProgress = false;
+    this->_roamingScanInProgress = false;
+  }
   switch (newState)
   {
     case OffLine:
       endMDns(oldState);
       WiFi.disconnect(true);
+      if (this->_apActive)
+      {
+        stopAp();
+      }
       WiFi.mode(WIFI_OFF);
       this->blinkInternal(22000, 1320);
       break;
@@ -676,7 +1622,15 @@ void IotWebConf::stateChanged(NetworkState oldState, NetworkState newState)
         endMDns(oldState);
         WiFi.disconnect(true);
       }
-      setupAp();
+      if (this->_apActive && ((oldState == Connecting) || (oldState == OnLine)))
+      {
+        // -- AP was kept alive in AP+STA mode.
+        WiFi.mode(WIFI_AP);
+      }
+      else
+      {
+        setupAp();
+      }
       if (this->_updateServerSetupFunction != nullptr)
       {
         this->_updateServerSetupFunction(this->_updatePath);
@@ -708,13 +1662,13 @@ void IotWebConf::stateChanged(NetworkState oldState, NetworkState newState)
       else
       {
         Serial.print(F("AP timeout (ms): "));
-        Serial.println(this->_apTimeoutMs);
+        Serial.println(this->getApRetryDelayMs());
       }
 #endif
       break;
     case Connecting:
-      if ((oldState == ApMode) ||
-          (oldState == NotConfigured))
+      if (((oldState == ApMode) ||
+          (oldState == NotConfigured)) && !this->_apStaMode)
       {
         stopAp();
       }
@@ -725,30 +1679,38 @@ void IotWebConf::stateChanged(NetworkState oldState, NetworkState newState)
       }
       endMDns(oldState);
       this->blinkInternal(1000, 500);
-#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
-      Serial.print("Connecting to [");
-      Serial.print(this->_wifiAuthInfo.ssid);
-# ifdef IOTWEBCONF_DEBUG_PWD_TO_SERIAL
-      Serial.print("] with password [");
-      Serial.print(this->_wifiAuthInfo.password);
-      Serial.println("]");
-# else
-      Serial.println(F("] (password is hidden)"));
-# endif
-      Serial.print(F("WiFi timeout (ms): "));
-      Serial.println(this->_wifiConnectionTimeoutMs);
-#endif
       this->_wifiConnectionStart = millis();
       // The order of WiFi.mode and WiFi.setHostname matters based on the platform
 #ifdef ESP8266
-      WiFi.mode(WIFI_STA);
+      WiFi.mode(this->_apActive ? WIFI_AP_STA : WIFI_STA);
       WiFi.hostname(this->_thingName);
 #elif defined(ESP32)
       WiFi.setHostname(this->_thingName);
-      WiFi.mode(WIFI_STA);
+      WiFi.mode(this->_apActive ? WIFI_AP_STA : WIFI_STA);
+#endif
+      if (this->_directedConnection)
+      {
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+        Serial.print(F("Connecting directly to ["));
+        Serial.print(this->_wifiAuthInfo.ssid);
+        Serial.print(F("] on channel "));
+        Serial.println(this->_directedChannel);
 #endif
-      this->_wifiConnectionHandler(
-          this->_wifiAuthInfo.ssid, this->_wifiAuthInfo.password);
+        WiFi.begin(
+          this->_wifiAuthInfo.ssid, this->_wifiAuthInfo.password,
+          this->_directedChannel, this->_directedBssid);
+      }
+      else if ((oldState != Connecting) && (this->_wifiScanResultHandler != nullptr))
+      {
+        // -- New connection round, look around before selecting a network.
+        IOTWEBCONF_DEBUG_LINE(F("Scanning for WiFi networks"));
+        WiFi.scanNetworks(true);
+        this->_wifiScanInProgress = true;
+      }
+      else
+      {
+        this->startWifiConnection();
+      }
       break;
     case OnLine:
       // -- Initialize mdns after network connection
@@ -760,6 +1722,13 @@ void IotWebConf::stateChanged(NetworkState oldState, NetworkState newState)
 # endif
 #endif
       this->blinkInternal(8000, 160);
+      this->_directedConnection = false;
+      this->_connectionAttemptCount = 0;
+      this->_onLineStartMs = millis();
+      this->_roamingLastSampleMs = this->_onLineStartMs;
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+      this->saveWarmBootSnapshot();
+#endif
       if (this->_updateServerUpdateCredentialsFunction != nullptr)
       {
         this->_updateServerUpdateCredentialsFunction(
@@ -782,15 +1751,37 @@ void IotWebConf::checkApTimeout()
   if ( !mustStayInApMode() )
   {
     // -- Only move on, when we have a valid WifF and AP configured.
-    if ((this->_apConnectionState == Disconnected) ||
-        (((millis() - this->_apStartTimeMs) > this->_apTimeoutMs) &&
-         (this->_apConnectionState != HasConnection)))
+    if (this->_apConnectionState == Disconnected)
+    {
+      this->changeState(Connecting, CauseStationLeft);
+    }
+    else if (((millis() - this->_apStartTimeMs) > this->getApRetryDelayMs()) &&
+         (this->_apConnectionState != HasConnection))
     {
-      this->changeState(Connecting);
+      this->changeState(Connecting, CauseTimeout);
     }
   }
 }
 
+/**
+ * All connection options failed, calculate the delay of the next round.
+ */
+void IotWebConf::connectionRoundFailed()
+{
+  this->_connectionAttemptCount++;
+  if (this->_reconnectPolicy != nullptr)
+  {
+    this->_reconnectDelayMs =
+      this->getReconnectDelayMs(this->_connectionAttemptCount);
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+    Serial.print(F("Connection attempt "));
+    Serial.print(this->_connectionAttemptCount);
+    Serial.print(F(" failed, retrying in (ms): "));
+    Serial.println(this->_reconnectDelayMs);
+#endif
+  }
+}
+
 void IotWebConf::goOnLine(bool apMode)
 {
   if (this->_state != OffLine)
@@ -800,11 +1791,11 @@ void IotWebConf::goOnLine(bool apMode)
   }
   if (apMode || mustStayInApMode())
   {
-    this->changeState(ApMode);
+    this->changeState(ApMode, CauseRequested);
   }
   else
   {
-    this->changeState(Connecting);
+    this->changeState(Connecting, CauseRequested);
   }
 }
 
@@ -844,17 +1835,27 @@ bool IotWebConf::checkWifiConnection()
       // -- WiFi not available, fall back to AP mode.
       IOTWEBCONF_DEBUG_LINE(F("Giving up."));
       WiFi.disconnect(true);
+      if (this->_directedConnection)
+      {
+        // -- Directed connection failed, make a regular connection instead.
+        IOTWEBCONF_DEBUG_LINE(F("Directed connection failed."));
+        this->_directedConnection = false;
+        this->_wifiAuthInfo = this->_directedFallbackAuthInfo;
+        this->changeState(Connecting, CauseTimeout);
+        return false;
+      }
       WifiAuthInfo* newWifiAuthInfo = _wifiConnectionFailureHandler();
       if (newWifiAuthInfo != nullptr)
       {
         // -- Try connecting with another connection info.
         this->_wifiAuthInfo.ssid = newWifiAuthInfo->ssid;
         this->_wifiAuthInfo.password = newWifiAuthInfo->password;
-        this->changeState(Connecting);
+        this->changeState(Connecting, CauseFailureHandler);
       }
       else
       {
-        this->changeState(ApMode);
+        this->connectionRoundFailed();
+        this->changeState(ApMode, CauseTimeout);
       }
     }
     return false;
@@ -870,9 +1871,177 @@ bool IotWebConf::checkWifiConnection()
   return true;
 }
 
+/**
+ * Waits for the WiFi scan started on entering Connecting state, and
+ * lets the scan result handler select the network to connect to.
+ */
+void IotWebConf::checkWifiScan()
+{
+  int16_t networkCount = WiFi.scanComplete();
+  if (networkCount == WIFI_SCAN_RUNNING)
+  {
+    if ((millis() - this->_wifiConnectionStart) <= this->_wifiConnectionTimeoutMs)
+    {
+      return;
+    }
+    IOTWEBCONF_DEBUG_LINE(F("WiFi scan timed out."));
+  }
+  this->_wifiScanInProgress = false;
+
+  if (networkCount >= 0)
+  {
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+    Serial.print(F("WiFi networks found: "));
+    Serial.println(networkCount);
+#endif
+    WifiAuthInfo* newWifiAuthInfo = this->_wifiScanResultHandler(networkCount);
+    WiFi.scanDelete();
+    if (newWifiAuthInfo == nullptr)
+    {
+      IOTWEBCONF_DEBUG_LINE(F("No known WiFi network in range."));
+      this->connectionRoundFailed();
+      this->changeState(ApMode, CauseNoNetwork);
+      return;
+    }
+    this->_wifiAuthInfo.ssid = newWifiAuthInfo->ssid;
+    this->_wifiAuthInfo.password = newWifiAuthInfo->password;
+  }
+  else
+  {
+    // -- Scan failed, continue with the current connection info.
+    WiFi.scanDelete();
+    IOTWEBCONF_DEBUG_LINE(F("WiFi scan failed."));
+  }
+
+  this->_wifiConnectionStart = millis();
+  this->startWifiConnection();
+}
+
+/**
+ * Samples signal strength while OnLine, and starts a background scan
+ * if the signal became weak.
+ */
+void IotWebConf::checkRoaming()
+{
+  if (this->_roamingScanInProgress)
+  {
+    checkRoamingScan();
+    return;
+  }
+
+  unsigned long now = millis();
+  if (((now - this->_onLineStartMs) < this->_roamingPolicy->minDwellMs) ||
+    ((now - this->_roamingLastSampleMs) < this->_roamingPolicy->sampleIntervalMs))
+  {
+    return;
+  }
+  this->_roamingLastSampleMs = now;
+
+  if ((WiFi.RSSI() >= this->_roamingPolicy->rssiThreshold) ||
+    ((this->_roamingLastScanMs != 0) &&
+      ((now - this->_roamingLastScanMs) < this->_roamingPolicy->scanIntervalMs)))
+  {
+    return;
+  }
+
+  IOTWEBCONF_DEBUG_LINE(F("Weak signal, scanning for roaming candidates."));
+  this->_roamingLastScanMs = now;
+  WiFi.scanNetworks(true);
+  this->_roamingScanInProgress = true;
+}
+
+/**
+ * Evaluates the background scan results, and moves to a clearly
+ * better access point, if there is one.
+ */
+void IotWebConf::checkRoamingScan()
+{
+  int16_t networkCount = WiFi.scanComplete();
+  if (networkCount == WIFI_SCAN_RUNNING)
+  {
+    return;
+  }
+  this->_roamingScanInProgress = false;
+
+  int32_t currentRssi = WiFi.RSSI();
+  uint8_t* currentBssid = WiFi.BSSID();
+  int32_t bestRssi = currentRssi + this->_roamingPolicy->rssiHysteresis;
+  int bestIndex = -1;
+  WifiAuthInfo* bestWifiAuthInfo = nullptr;
+  for (int i = 0; i < networkCount; i++)
+  {
+    int32_t rssi = WiFi.RSSI(i);
+    if ((rssi < bestRssi) ||
+      ((currentBssid != nullptr) && (memcmp(WiFi.BSSID(i), currentBssid, 6) == 0)))
+    {
+      continue;
+    }
+    String ssid = WiFi.SSID(i);
+    WifiAuthInfo* wifiAuthInfo = nullptr;
+    if (ssid.equals(this->_wifiAuthInfo.ssid))
+    {
+      wifiAuthInfo = &this->_wifiAuthInfo;
+    }
+    else if (this->_roamingCandidateHandler != nullptr)
+    {
+      wifiAuthInfo = this->_roamingCandidateHandler(ssid.c_str());
+    }
+    if (wifiAuthInfo != nullptr)
+    {
+      bestRssi = rssi;
+      bestIndex = i;
+      bestWifiAuthInfo = wifiAuthInfo;
+    }
+  }
+
+  if (bestIndex < 0)
+  {
+    WiFi.scanDelete();
+    return;
+  }
+
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+  Serial.print(F("Roaming candidate found with RSSI "));
+  Serial.print(bestRssi);
+  Serial.print(F(" (current: "));
+  Serial.print(currentRssi);
+  Serial.println(F(")"));
+#endif
+  memcpy(this->_directedBssid, WiFi.BSSID(bestIndex), 6);
+  this->_directedChannel = WiFi.channel(bestIndex);
+  WiFi.scanDelete();
+
+  // -- On failure return to the network we were connected to.
+  this->_directedFallbackAuthInfo = this->_wifiAuthInfo;
+  this->_wifiAuthInfo.ssid = bestWifiAuthInfo->ssid;
+  this->_wifiAuthInfo.password = bestWifiAuthInfo->password;
+  this->_directedConnection = true;
+  this->changeState(Connecting, CauseRoaming);
+}
+
+void IotWebConf::startWifiConnection()
+{
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+  Serial.print("Connecting to [");
+  Serial.print(this->_wifiAuthInfo.ssid);
+# ifdef IOTWEBCONF_DEBUG_PWD_TO_SERIAL
+  Serial.print("] with password [");
+  Serial.print(this->_wifiAuthInfo.password);
+  Serial.println("]");
+# else
+  Serial.println(F("] (password is hidden)"));
+# endif
+  Serial.print(F("WiFi timeout (ms): "));
+  Serial.println(this->_wifiConnectionTimeoutMs);
+#endif
+  this->_wifiConnectionHandler(
+      this->_wifiAuthInfo.ssid, this->_wifiAuthInfo.password);
+}
+
 void IotWebConf::setupAp()
 {
   WiFi.mode(WIFI_AP);
+  this->_captivePortalLocation[0] = '\0';
 
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
   Serial.print("Setting up AP: ");
@@ -912,14 +2081,46 @@ void IotWebConf::setupAp()
   //  Serial.println(WiFi.softAPIP());
 
   /* Setup the DNS server redirecting all the domains to the apIP */
-  this->_dnsServer->setErrorReplyCode(DNSReplyCode::NoError);
-  this->_dnsServer->start(IOTWEBCONF_DNS_PORT, "*", WiFi.softAPIP());
+  if (this->_dnsResponder != nullptr)
+  {
+    this->_dnsResponder->start(IOTWEBCONF_DNS_PORT, WiFi.softAPIP());
+  }
+  else
+  {
+    this->_dnsServer->setErrorReplyCode(DNSReplyCode::NoError);
+    this->_dnsServer->start(IOTWEBCONF_DNS_PORT, "*", WiFi.softAPIP());
+  }
+  this->_apActive = true;
 }
 
 void IotWebConf::stopAp()
 {
   WiFi.softAPdisconnect(true);
   WiFi.mode(WIFI_OFF);
+  this->_apActive = false;
+}
+
+/**
+ * In AP+STA mode, stop the AP after the WiFi connection became stable.
+ */
+void IotWebConf::checkApShutdown()
+{
+  this->processDns();
+  if ((millis() - this->_onLineStartMs) > this->_apStaShutdownDelayMs)
+  {
+    IOTWEBCONF_DEBUG_LINE(F("WiFi connection is stable, stopping AP."));
+    if (this->_dnsResponder != nullptr)
+    {
+      this->_dnsResponder->stop();
+    }
+    else
+    {
+      this->_dnsServer->stop();
+    }
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    this->_apActive = false;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -986,7 +2187,7 @@ void IotWebConf::forceApMode(bool doForce)
     if (this->_state != ApMode)
     {
       IOTWEBCONF_DEBUG_LINE(F("Start forcing AP mode"));
-      this->changeState(ApMode);
+      this->changeState(ApMode, CauseForced);
     }
   }
   else
@@ -1000,12 +2201,37 @@ void IotWebConf::forceApMode(bool doForce)
       else
       {
         IOTWEBCONF_DEBUG_LINE(F("Stopping AP mode force."));
-        this->changeState(Connecting);
+        this->changeState(Connecting, CauseForced);
       }
     }
   }
 }
 
+/**
+ * Time to wait in AP mode before the next connection round, calculated
+ * from the reconnect policy.
+ *   @attempt - Number of failed connection rounds in a row (starting with 1).
+ */
+unsigned long IotWebConf::getReconnectDelayMs(unsigned int attempt)
+{
+  ReconnectPolicy* policy = this->_reconnectPolicy;
+  float delayMs = policy->initialDelayMs;
+  for (unsigned int i = 1; (i < attempt) && (delayMs < policy->maxDelayMs); i++)
+  {
+    delayMs *= policy->multiplier;
+  }
+  if (delayMs > policy->maxDelayMs)
+  {
+    delayMs = policy->maxDelayMs;
+  }
+  long jitter = (long)(delayMs * policy->jitterPercent / 100);
+  if (jitter > 0)
+  {
+    delayMs += random(-jitter, jitter + 1);
+  }
+  return delayMs < 0 ? 0 : (unsigned long)delayMs;
+}
+
 bool IotWebConf::connectAp(const char* apName, const char* password)
 {
   return WiFi.softAP(apName, password);
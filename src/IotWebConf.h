@@ -13,8 +13,10 @@
 #define IotWebConf_h
 
 #include <Arduino.h>
+#include <IotWebConfDnsResponder.h>
 #include <IotWebConfParameter.h>
 #include <IotWebConfSettings.h>
+#include <IotWebConfValidation.h>
 #include <IotWebConfWebServerWrapper.h>
 
 #ifdef ESP8266
@@ -69,6 +71,61 @@ enum NetworkState
   OffLine
 };
 
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+// -- Boot phases recorded by the boot profiler.
+enum BootPhase
+{
+  BootPhaseInitStart, // -- init() was called.
+  BootPhasePinsReady, // -- Config and status pins are set up.
+  BootPhaseConfigSized, // -- Storage size of the configuration is calculated.
+  BootPhaseEepromOpened, // -- EEPROM.begin() returned.
+  BootPhaseValuesLoaded, // -- Parameter values are loaded (or defaults applied).
+  BootPhaseConfigDumped, // -- Configuration was dumped to Serial.
+  BootPhaseInitDone, // -- init() returns.
+  BootPhaseFirstState, // -- Boot state was left (AP mode, Connecting or OffLine).
+  BootPhaseConnecting, // -- First WiFi connection attempt started.
+  BootPhaseOnLine, // -- First time OnLine.
+  BootPhaseCount
+};
+#endif
+
+// -- Cause of a network state change.
+enum TransitionCause
+{
+  CauseUnknown,
+  CauseBoot, // -- Startup state selected after boot.
+  CauseTimeout, // -- AP mode or WiFi connection timed out.
+  CauseStationLeft, // -- All clients have left the AP.
+  CauseForced, // -- AP mode was forced, or force was released.
+  CauseFailureHandler, // -- WiFi connection failure handler provided another network.
+  CauseNoNetwork, // -- No known WiFi network was found by the scan.
+  CauseWifiLost, // -- WiFi connection was lost.
+  CauseConnected, // -- WiFi connection was established.
+  CauseRoaming, // -- Roaming to another access point.
+  CauseRequested // -- Requested by goOnLine() or goOffLine().
+};
+
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+// -- A state change recorded in the state trace.
+typedef struct StateTransition
+{
+  uint32_t timeMs; // -- millis() of the state change.
+  uint8_t oldState; // -- NetworkState
+  uint8_t newState; // -- NetworkState
+  uint8_t cause; // -- TransitionCause
+  char ssid[IOTWEBCONF_STATE_TRACE_SSID_LEN]; // -- SSID in use (or attempted), maybe truncated.
+} StateTransition;
+
+typedef struct StateTrace
+{
+  uint32_t magic;
+  uint32_t checksum; // -- Covers everything after this field.
+  uint16_t head; // -- Index of the next record to write.
+  uint16_t count;
+  StateTransition records[IOTWEBCONF_STATE_TRACE_SIZE];
+} StateTrace;
+#endif
+
 class IotWebConf;
 
 typedef struct WifiAuthInfo
@@ -77,6 +134,66 @@ typedef struct WifiAuthInfo
   const char* password;
 } WifiAuthInfo;
 
+/**
+ * Settings for roaming between access points. See IotWebConf::setRoamingPolicy().
+ */
+typedef struct RoamingPolicy
+{
+  // -- Background scan is only started, when signal is weaker than this (dBm).
+  int32_t rssiThreshold = IOTWEBCONF_DEFAULT_ROAMING_RSSI_THRESHOLD;
+  // -- Candidate must be stronger than the current signal at least with this amount (dB).
+  int32_t rssiHysteresis = IOTWEBCONF_DEFAULT_ROAMING_RSSI_HYSTERESIS;
+  // -- Signal strength of the current connection is sampled with this period.
+  unsigned long sampleIntervalMs = IOTWEBCONF_DEFAULT_ROAMING_SAMPLE_INTERVAL_MS;
+  // -- Minimal time between two background scans.
+  unsigned long scanIntervalMs = IOTWEBCONF_DEFAULT_ROAMING_SCAN_INTERVAL_MS;
+  // -- Minimal time to stay on an access point after connection.
+  unsigned long minDwellMs = IOTWEBCONF_DEFAULT_ROAMING_MIN_DWELL_MS;
+} RoamingPolicy;
+
+/**
+ * Exponential backoff for retrying WiFi connection after failed connection rounds.
+ * See IotWebConf::setReconnectPolicy().
+ */
+typedef struct ReconnectPolicy
+{
+  // -- Delay after the first failed connection round.
+  unsigned long initialDelayMs = IOTWEBCONF_DEFAULT_RECONNECT_INITIAL_DELAY_MS;
+  // -- Delay is multiplied by this value after each further failed round.
+  float multiplier = IOTWEBCONF_DEFAULT_RECONNECT_MULTIPLIER;
+  // -- Delay will not grow over this value.
+  unsigned long maxDelayMs = IOTWEBCONF_DEFAULT_RECONNECT_MAX_DELAY_MS;
+  // -- Delay is randomly adjusted with +/- this percent.
+  byte jitterPercent = IOTWEBCONF_DEFAULT_RECONNECT_JITTER_PERCENT;
+} ReconnectPolicy;
+
+/**
+ * Listener, that is notified after saveConfig(), when the stored value of the
+ * observed item changed. A group is observed as a whole: the listener is called
+ * once per save, no matter how many items of the group changed.
+ * The observed item is passed to the listener, so the new value can be read
+ * through its own (typed) accessors.
+ * The listener keeps a copy of the stored value of the item in RAM, so observe
+ * items rather than large groups where possible.
+ * See IotWebConf::addChangeListener().
+ */
+class ChangeListener
+{
+public:
+  ChangeListener(
+    ConfigItem* item, std::function<void(ConfigItem* item)> onChange) :
+    _item(item), _onChange(onChange) { }
+  ConfigItem* getItem() { return this->_item; }
+
+private:
+  ConfigItem* _item;
+  std::function<void(ConfigItem* item)> _onChange;
+  byte* _snapshot = nullptr;
+  int _snapshotSize = 0;
+  ChangeListener* _nextListener = nullptr;
+  friend class IotWebConf;
+};
+
 /**
  * Class for providing HTML format segments.
  */
@@ -115,6 +232,9 @@ public:
     { this->_server->requestAuthentication(); };
   bool hasArg(const String& name) override { return this->_server->hasArg(name); };
   String arg(const String name) override { return this->_server->arg(name); };
+  int args() override { return this->_server->args(); };
+  String argName(int i) override { return this->_server->argName(i); };
+  String arg(int i) override { return this->_server->arg(i); };
   void sendHeader(const String& name, const String& value, bool first = false) override
     { this->_server->sendHeader(name, value, first); };
   void setContentLength(const size_t contentLength) override
@@ -227,6 +347,17 @@ public:
     this->_updatePath = updatePath;
   }
 
+  /**
+   * Add a pull based update client to the system (e.g. HTTPUpdateClient).
+   * The provided function is called from doLoop() while the Thing is
+   * on-line, and should perform a short, non-blocking step of the client.
+   *   @updateClientLoop - Performs a step of the update client.
+   */
+  void setupUpdateClient(std::function<void()> updateClientLoop)
+  {
+    this->_updateClientLoopFunction = updateClientLoop;
+  }
+
   /**
    * Start up the IotWebConf module.
    * Loads all configuration from the EEPROM, and initialize the system.
@@ -262,6 +393,20 @@ public:
     handleConfig(&webRequestWrapper);
   }
 
+  /**
+   * Config export web request handler. Responds with all the config items in
+   * JSON format (see writeJson()), sent in chunks. Requires admin
+   * authentication. Register it for a URL of your choice, e.g. "/config.json".
+   */
+  void handleConfigJson(
+    WebRequestWrapper* webRequestWrapper,
+    JsonPasswordPolicy passwordPolicy = JsonPasswordOmit);
+  void handleConfigJson(JsonPasswordPolicy passwordPolicy = JsonPasswordOmit)
+  {
+    StandardWebRequestWrapper webRequestWrapper = StandardWebRequestWrapper(this->_standardWebServerWrapper._server);
+    handleConfigJson(&webRequestWrapper, passwordPolicy);
+  }
+
   /**
    * URL-not-found web request handler. Used for handling captive portal request.
    */
@@ -272,6 +417,45 @@ public:
     handleNotFound(&webRequestWrapper);
   }
 
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+  /**
+   * Boot profile web request handler. Responds with the recorded boot phase
+   * timestamps in plain text. Register it for a diagnostics URL of your choice.
+   */
+  void handleBootProfile(WebRequestWrapper* webRequestWrapper);
+  void handleBootProfile()
+  {
+    StandardWebRequestWrapper webRequestWrapper = StandardWebRequestWrapper(this->_standardWebServerWrapper._server);
+    handleBootProfile(&webRequestWrapper);
+  }
+
+  /**
+   * Returns the micros() timestamp, when the boot phase was first reached, or
+   * 0 if the phase was not (yet) reached.
+   * Only available when compiled with IOTWEBCONF_ENABLE_BOOT_PROFILER.
+   */
+  unsigned long getBootPhaseMicros(BootPhase phase)
+  {
+    return phase < BootPhaseCount ? this->_bootPhaseMicros[phase] : 0;
+  }
+
+  /**
+   * Returns the name of the boot phase, e.g. "valuesLoaded".
+   */
+  static const char* getBootPhaseName(BootPhase phase);
+#endif
+
+  /**
+   * Use the provided DnsResponder for the captive portal instead of the DNSServer
+   * passed to the constructor. DnsResponder answers all pending queries in a loop,
+   * and is much faster answering the parallel queries of a phone joining the AP.
+   * Must be called before init()!
+   */
+  void setDnsResponder(DnsResponder* dnsResponder)
+  {
+    this->_dnsResponder = dnsResponder;
+  }
+
   /**
    * Specify a callback method, that will be called upon WiFi connection success.
    * Should be called before init()!
@@ -293,6 +477,26 @@ public:
    */
   void setConfigSavedCallback(std::function<void()> func);
 
+  /**
+   * Keep a config stored with a previous config version, when only its
+   * layout has changed (e.g. checkboxes were moved into a FlagGroup).
+   * The layout handler is called with true before loading a config of the
+   * legacy version, and should switch the items to the previous layout
+   * (e.g. FlagGroup::setLegacyLayout()). It is called with false afterwards,
+   * and the config is saved again with the current version and layout.
+   * Should be called before init()!
+   */
+  void setLegacyConfigVersion(
+    const char* legacyConfigVersion, std::function<void(bool legacy)> layoutHandler);
+
+  /**
+   * Add a listener, that is called after saving the configuration, when the
+   * value of the observed item (or any item of the observed group) has changed.
+   * Listeners are called before the config saved callback.
+   * Items should be added to the observed group before the listener is added.
+   */
+  void addChangeListener(ChangeListener* listener);
+
   /**
    * Specify a callback method, that will be called when form validation is required.
    * If the method will return false, the configuration will not be saved.
@@ -300,6 +504,13 @@ public:
    */
   void setFormValidator(std::function<bool(WebRequestWrapper* webRequestWrapper)> func);
 
+  /**
+   * Add a declarative constraint, that is checked on form post together with
+   * the built-in ones. All constraints are evaluated in a single pass, before
+   * the form validator is called, and all failing items get their error message.
+   */
+  void addConstraint(Constraint* constraint);
+
   /**
    * Specify your custom Access Point connection handler. Please use IotWebConf::connectAp() as
    * reference when implementing your custom solution.
@@ -339,6 +550,46 @@ public:
     _wifiConnectionFailureHandler = func;
   }
 
+  /**
+   * With this method you can request an asynchronous WiFi scan at the beginning of
+   * each connection round (when entering Connecting state from any other state).
+   * The handler is called once the scan is completed with the number of networks found.
+   * Scan results can be queried with WiFi.SSID(i), WiFi.RSSI(i) while the handler runs.
+   * The handler should return the connection info to try first, or nullptr, when
+   * none of the known networks is in range. In the latter case no connection
+   * is attempted, and IotWebConf falls back to AP mode immediately.
+   * If the scan itself fails, the current WiFi auth info is used as without the scan.
+   * Note, that this feature is utilized by the MultipleWifiAddition class. (See IotWebConfMultipleWifi.h)
+   */
+  void setWifiScanResultHandler( std::function<WifiAuthInfo*(int networkCount)> func )
+  {
+    _wifiScanResultHandler = func;
+  }
+
+  /**
+   * Enables roaming in OnLine state. The signal strength is sampled periodically, and
+   * when it drops under the threshold, a background WiFi scan is performed. If a
+   * known access point is found with a signal clearly better than the current one
+   * (see RoamingPolicy for details), IotWebConf reconnects to that very access point (BSSID).
+   * Note, that roaming connects with WiFi.begin() directly, so custom WiFi connection
+   * handler is not called for roaming attempts. If the roaming attempt fails, a
+   * regular connection is made to the previous network.
+   *   @policy - Roaming settings, must be kept alive by the caller. nullptr disables roaming.
+   */
+  void setRoamingPolicy(RoamingPolicy* policy) { this->_roamingPolicy = policy; }
+
+  /**
+   * By default roaming only considers other access points of the network we are
+   * connected to. With this handler further networks can be accepted: the handler
+   * is called with the SSID of each network found during the roaming scan, and should
+   * return the connection info of that network, or nullptr if the network is unknown.
+   * Note, that this feature is utilized by the MultipleWifiAddition class. (See IotWebConfMultipleWifi.h)
+   */
+  void setRoamingCandidateHandler( std::function<WifiAuthInfo*(const char* ssid)> func )
+  {
+    _roamingCandidateHandler = func;
+  }
+
   /**
    * Add a custom parameter group, that will be handled by the IotWebConf module.
    * The parameters in this group will be saved to/loaded from EEPROM automatically,
@@ -439,6 +690,60 @@ public:
    */
   unsigned long getApTimeoutMs() { return this->_apTimeoutMs; };
 
+  /**
+   * With a reconnect policy set, IotWebConf will wait for an exponentially
+   * growing (randomized) time in AP mode after each failed connection round,
+   * instead of the fixed AP timeout. The count is reset by a successful connection.
+   *   @policy - Backoff settings, must be kept alive by the caller. nullptr disables backoff.
+   */
+  void setReconnectPolicy(ReconnectPolicy* policy) { this->_reconnectPolicy = policy; }
+
+  /**
+   * Returns the number of failed connection rounds since the last successful connection.
+   */
+  unsigned int getConnectionAttemptCount() { return this->_connectionAttemptCount; }
+
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+  /**
+   * Returns the number of state changes kept in the state trace.
+   * Only available when compiled with IOTWEBCONF_ENABLE_STATE_TRACE.
+   */
+  int getStateTransitionCount() { return this->_stateTrace.count; }
+
+  /**
+   * Returns a recorded state change, index 0 being the most recent one.
+   * Returns nullptr, when index is out of range.
+   */
+  const StateTransition* getStateTransition(int index);
+
+  /**
+   * Drops all records of the state trace.
+   */
+  void clearStateTrace();
+
+  /**
+   * State trace web request handler. Responds with the recorded state changes
+   * (oldest first) as a compact JSON array of
+   * [timeMs, oldState, newState, cause, "ssid"] items.
+   * Register it for a diagnostics URL of your choice.
+   */
+  void handleStateTrace(WebRequestWrapper* webRequestWrapper);
+  void handleStateTrace()
+  {
+    StandardWebRequestWrapper webRequestWrapper = StandardWebRequestWrapper(this->_standardWebServerWrapper._server);
+    handleStateTrace(&webRequestWrapper);
+  }
+#endif
+
+  /**
+   * Returns the time (in millis()) when the next connection round is due in AP mode.
+   * Note, that the connection might be delayed further, while a client is connected to the AP.
+   */
+  unsigned long getNextConnectionAttemptMs()
+  {
+    return this->_apStartTimeMs + this->getApRetryDelayMs();
+  }
+
     /**
    * Returns the current WiFi authentication credentials. These are usually the configured ones,
    * but might be overwritten by setWifiConnectionFailedHandler().
@@ -468,6 +773,32 @@ public:
    */
   void skipApStartup() { this->_skipApStartup = true; }
 
+  /**
+   * By default IotWebConf shuts down the AP when trying to connect to the WiFi network,
+   * so the config portal is unavailable while connecting. With this method the
+   * AP+STA mode is enabled: the AP (and the captive portal) is kept alive during
+   * connection attempts, and is shut down only after the WiFi connection was
+   * stable for the time provided.
+   * Note, that in AP+STA mode the AP must follow the channel of the WiFi network,
+   * so clients might need to rejoin the AP once.
+   * Must be called before init()!
+   *   @apShutdownDelayMs - Time the WiFi connection must be stable before stopping the AP.
+   */
+  void enableApStaMode(
+    unsigned long apShutdownDelayMs = IOTWEBCONF_DEFAULT_AP_STA_SHUTDOWN_DELAY_MS)
+  {
+    this->_apStaMode = true;
+    this->_apStaShutdownDelayMs = apShutdownDelayMs;
+  }
+
+  /**
+   * Returns true, if the configuration was restored from RTC memory on init() (e.g. after
+   * deep sleep) instead of reading it from the EEPROM. In this case IotWebConf skips the
+   * AP startup, and connects directly to the access point used before.
+   * Warm boot is only available when compiled with IOTWEBCONF_ENABLE_WARM_BOOT.
+   */
+  bool isWarmBoot() { return this->_warmBoot; }
+
   /**
    * By default IotWebConf will continue startup in WiFi mode, when no configuration request arrived
    * in AP mode. With this method holding the AP mode can be forced.
@@ -480,7 +811,7 @@ public:
   /**
    *
    */
-  void goOffLine() { this->changeState(OffLine); }
+  void goOffLine() { this->changeState(OffLine, CauseRequested); }
 
   /**
    *
@@ -505,6 +836,53 @@ public:
   {
     return &this->_systemParameters;
   };
+
+  /**
+   * Find a config item (parameter or group) by its id, e.g. for applying values
+   * arriving from MQTT. Returns nullptr, if no item has the provided id.
+   * For the ids of a CompactParameterGroup, the group is returned.
+   * Ids are looked up in a sorted index built by init(), so all the items
+   * must be added before init(). If there are more ids than
+   * IOTWEBCONF_ITEM_INDEX_SIZE, the item tree is searched instead.
+   */
+  ConfigItem* findItem(const char* id);
+
+  /**
+   * Applies a value (in the form the config portal posts it) to the item
+   * with the provided id, and lets the enclosing groups know about it (e.g.
+   * an element of a RepeatedParameterGroup becomes live). Returns false, if
+   * no item accepted the value.
+   * Do not forget to call saveConfig() afterwards!
+   */
+  bool applyValue(const char* id, const String& value);
+
+  /**
+   * Applies the values of a JSON config (e.g. a file), that is read from
+   * the stream piece by piece, so no JSON document is built in the memory.
+   * Keys are matched against the ids of the items, so nesting of the groups
+   * is optional. Values are applied as they arrive, so a false return
+   * value (invalid JSON) means, that the config might be applied partially.
+   * Do not forget to call saveConfig() afterwards!
+   * Does not require IOTWEBCONF_ENABLE_JSON nor ArduinoJson.
+   */
+  bool loadFromJsonStream(Stream* in);
+
+  /**
+   * Writes all the config items as JSON, groups as nested objects keyed by
+   * their ids (the same structure loadFromJsonStream() accepts). The output
+   * is written while walking the items, so no document is built in the
+   * memory.
+   *   @passwordPolicy - Whether passwords are omitted, written as empty
+   *     strings or written as they are.
+   */
+  void writeJson(Print* out, JsonPasswordPolicy passwordPolicy = JsonPasswordOmit);
+
+  /**
+   * Print the estimated RAM and the EEPROM usage of every config item, one
+   * line per item, followed by the totals. Use it to compare the cost of
+   * different parameter representations.
+   */
+  void memoryReportTo(Stream* out);
   Parameter* getThingNameParameter()
   {
     return &this->_thingNameParameter;
@@ -562,12 +940,15 @@ private:
   const char* _initialApPassword = nullptr;
   const char* _configVersion;
   DNSServer* _dnsServer;
+  DnsResponder* _dnsResponder = nullptr;
+  char _captivePortalLocation[30] = { 0 }; // -- "http://255.255.255.255:65535/"
   WebServerWrapper* _webServerWrapper;
   StandardWebServerWrapper _standardWebServerWrapper = StandardWebServerWrapper();
   std::function<void(const char* _updatePath)>
     _updateServerSetupFunction = nullptr;
   std::function<void(const char* userName, char* password)>
     _updateServerUpdateCredentialsFunction = nullptr;
+  std::function<void()> _updateClientLoopFunction = nullptr;
   int _configPin = -1;
   int _statusPin = -1;
   int _statusOnLevel = LOW;
@@ -576,7 +957,21 @@ private:
   bool _startupOffLine = false;
   bool _skipApStartup = false;
   bool _forceApMode = false;
+  bool _warmBoot = false;
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+  char _warmBootSsid[IOTWEBCONF_WORD_LEN];
+  char _warmBootPassword[IOTWEBCONF_PASSWORD_LEN];
+#endif
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+  unsigned long _bootPhaseMicros[BootPhaseCount] = { 0 };
+#endif
+  bool _apStaMode = false;
+  bool _apActive = false;
+  unsigned long _apStaShutdownDelayMs = IOTWEBCONF_DEFAULT_AP_STA_SHUTDOWN_DELAY_MS;
   ParameterGroup _allParameters = ParameterGroup("iwcAll");
+  ItemIndex::Entry _itemIndexEntries[IOTWEBCONF_ITEM_INDEX_SIZE];
+  ItemIndex _itemIndex =
+    ItemIndex(this->_itemIndexEntries, IOTWEBCONF_ITEM_INDEX_SIZE);
   ParameterGroup _systemParameters = ParameterGroup("iwcSys", "System configuration");
   ParameterGroup _customParameterGroups = ParameterGroup("iwcCustom");
   ParameterGroup _hiddenParameters = ParameterGroup("hidden");
@@ -587,6 +982,16 @@ private:
     PasswordParameter("AP password", "iwcApPassword", this->_apPassword, IOTWEBCONF_PASSWORD_LEN);
   NumberParameter _apTimeoutParameter =
     NumberParameter("Startup delay (seconds)", "iwcApTimeout", this->_apTimeoutStr, IOTWEBCONF_WORD_LEN, IOTWEBCONF_DEFAULT_AP_MODE_TIMEOUT_SECS, nullptr, "min='1' max='600'");
+  LengthConstraint _thingNameConstraint =
+    LengthConstraint(&this->_thingNameParameter,
+      "Give a name with at least 3 characters.", 3);
+  LengthConstraint _apPasswordConstraint =
+    LengthConstraint(&this->_apPasswordParameter,
+      "Password length must be at least 8 characters.", 8, 0, true);
+  LengthConstraint _wifiPasswordConstraint =
+    LengthConstraint(&this->_wifiParameters.wifiPasswordParameter,
+      "Password length must be at least 8 characters.", 8, 0, true);
+  Constraint* _firstConstraint = nullptr;
   char _thingName[IOTWEBCONF_WORD_LEN];
   char _apPassword[IOTWEBCONF_PASSWORD_LEN];
   char _apTimeoutStr[IOTWEBCONF_WORD_LEN];
@@ -599,7 +1004,10 @@ private:
   ApConnectionState _apConnectionState = NoConnections;
   std::function<void()> _wifiConnectionCallback = nullptr;
   std::function<void(int)> _configSavingCallback = nullptr;
+  const char* _legacyConfigVersion = nullptr;
+  std::function<void(bool)> _legacyLayoutHandler = nullptr;
   std::function<void()> _configSavedCallback = nullptr;
+  ChangeListener* _firstChangeListener = nullptr;
   std::function<bool(WebRequestWrapper* webRequestWrapper)> _formValidator = nullptr;
   std::function<void(const char*, const char*)> _apConnectionHandler =
       &(IotWebConf::connectAp);
@@ -607,6 +1015,25 @@ private:
       &(IotWebConf::connectWifi);
   std::function<WifiAuthInfo*()> _wifiConnectionFailureHandler =
       &(IotWebConf::handleConnectWifiFailure);
+  std::function<WifiAuthInfo*(int)> _wifiScanResultHandler = nullptr;
+  bool _wifiScanInProgress = false;
+  ReconnectPolicy* _reconnectPolicy = nullptr;
+  unsigned int _connectionAttemptCount = 0;
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+  StateTrace _stateTrace = { 0 };
+#endif
+  unsigned long _reconnectDelayMs = 0;
+  RoamingPolicy* _roamingPolicy = nullptr;
+  std::function<WifiAuthInfo*(const char*)> _roamingCandidateHandler = nullptr;
+  bool _roamingScanInProgress = false;
+  unsigned long _onLineStartMs = 0;
+  unsigned long _roamingLastSampleMs = 0;
+  unsigned long _roamingLastScanMs = 0;
+  // -- Connect to a specific access point, fall back to a regular connection on failure.
+  bool _directedConnection = false;
+  uint8_t _directedBssid[6];
+  int32_t _directedChannel = 0;
+  WifiAuthInfo _directedFallbackAuthInfo;
   unsigned long _internalBlinkOnMs = 500;
   unsigned long _internalBlinkOffMs = 500;
   unsigned long _blinkOnMs = 500;
@@ -621,14 +1048,19 @@ private:
   HtmlFormatProvider* htmlFormatProvider = &htmlFormatProviderInstance;
 
   int initConfig();
-  bool testConfigVersion();
+  void snapshotChangeListener(ChangeListener* listener);
+  void notifyChangeListeners();
+  bool testConfigVersion(const char* configVersion);
   void saveConfigVersion();
-  void readEepromValue(int start, byte* valueBuffer, int length);
-  void writeEepromValue(int start, byte* valueBuffer, int length);
+#ifdef IOTWEBCONF_ENABLE_WARM_BOOT
+  bool loadWarmBootSnapshot();
+  void saveWarmBootSnapshot();
+  void invalidateWarmBootSnapshot();
+#endif
 
   bool validateForm(WebRequestWrapper* webRequestWrapper);
 
-  void changeState(NetworkState newState);
+  void changeState(NetworkState newState, TransitionCause cause = CauseUnknown);
   void stateChanged(NetworkState oldState, NetworkState newState);
   bool mustUseDefaultPassword()
   {
@@ -645,11 +1077,52 @@ private:
   void blinkInternal(unsigned long repeatMs, unsigned long onMs);
 
   void checkApTimeout();
+  void connectionRoundFailed();
+  unsigned long getApRetryDelayMs()
+  {
+    return ((this->_reconnectPolicy != nullptr) && (this->_connectionAttemptCount > 0)) ?
+      this->_reconnectDelayMs : this->_apTimeoutMs;
+  }
   void checkConnection();
   bool checkWifiConnection();
+  void checkWifiScan();
+  void startWifiConnection();
+  void checkRoaming();
+  void checkRoamingScan();
   void setupAp();
   void stopAp();
+  void processDns()
+  {
+    if (this->_dnsResponder != nullptr)
+    {
+      this->_dnsResponder->processNextRequest();
+    }
+    else
+    {
+      this->_dnsServer->processNextRequest();
+    }
+  }
+  void checkApShutdown();
+  unsigned long getReconnectDelayMs(unsigned int attempt);
   void endMDns(NetworkState oldState);
+#ifdef IOTWEBCONF_ENABLE_STATE_TRACE
+  void recordStateTransition(
+    NetworkState oldState, NetworkState newState, TransitionCause cause);
+# ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+  void loadStateTrace();
+  void persistStateTrace();
+# endif
+#endif
+#ifdef IOTWEBCONF_ENABLE_BOOT_PROFILER
+  void recordBootPhase(BootPhase phase)
+  {
+    // -- Only the first occurrence of a phase is recorded.
+    if (this->_bootPhaseMicros[phase] == 0)
+    {
+      this->_bootPhaseMicros[phase] = micros();
+    }
+  }
+#endif
 
   static bool connectAp(const char* apName, const char* password);
   static void connectWifi(const char* ssid, const char* password);
@@ -0,0 +1,414 @@
+/**
+ * IotWebConfCompactGroup.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "IotWebConfCompactGroup.h"
+
+namespace iotwebconf
+{
+
+CompactParameterGroup::CompactParameterGroup(
+  const char* id, const char* label,
+  const CompactParameterDescriptor* descriptors, byte count,
+  char* valueBuffer)
+  : ParameterGroup(id, label)
+{
+  this->_descriptors = descriptors;
+  this->_count = count;
+  this->_valueBuffer = valueBuffer;
+}
+
+void CompactParameterGroup::readDescriptor(
+  byte index, CompactParameterDescriptor* descriptor)
+{
+  memcpy_P(descriptor, &this->_descriptors[index], sizeof(CompactParameterDescriptor));
+}
+
+int CompactParameterGroup::getValuesLength()
+{
+  int length = 0;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    length += pgm_read_word(&this->_descriptors[i].length);
+  }
+  return length;
+}
+
+int CompactParameterGroup::indexOf(const char* id)
+{
+  for (byte i = 0; i < this->_count; i++)
+  {
+    const char* descriptorId =
+      (const char*)pgm_read_ptr(&this->_descriptors[i].id);
+    if (strcmp_P(id, descriptorId) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+ConfigItem* CompactParameterGroup::findItem(const char* id)
+{
+  return this->indexOf(id) >= 0 ? this : ParameterGroup::findItem(id);
+}
+
+bool CompactParameterGroup::addToIndex(ItemIndex* index)
+{
+  for (byte i = 0; i < this->_count; i++)
+  {
+    if (!index->add(this, i))
+    {
+      return false;
+    }
+  }
+  return ParameterGroup::addToIndex(index);
+}
+
+char* CompactParameterGroup::getValue(byte index)
+{
+  char* value = this->_valueBuffer;
+  for (byte i = 0; i < index; i++)
+  {
+    value += pgm_read_word(&this->_descriptors[i].length);
+  }
+  return value;
+}
+
+void CompactParameterGroup::setErrorMessage(byte index, const char* errorMessage)
+{
+  for (byte i = 0; i < this->_errorCount; i++)
+  {
+    if (this->_errors[i].index == index)
+    {
+      this->_errors[i].message = errorMessage;
+      return;
+    }
+  }
+  if (this->_errorCount < IOTWEBCONF_COMPACT_GROUP_MAX_ERRORS)
+  {
+    this->_errors[this->_errorCount].index = index;
+    this->_errors[this->_errorCount].message = errorMessage;
+    this->_errorCount++;
+  }
+}
+void CompactParameterGroup::setFieldErrorMessage(
+  const char* id, const char* errorMessage)
+{
+  int index = this->indexOf(id);
+  if (index >= 0)
+  {
+    this->setErrorMessage((byte)index, errorMessage);
+  }
+  else
+  {
+    this->setErrorMessage(errorMessage);
+  }
+}
+
+void CompactParameterGroup::applyDefaultValue()
+{
+  CompactParameterDescriptor descriptor;
+  char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    if (descriptor.defaultValue != nullptr)
+    {
+      strncpy_P(value, descriptor.defaultValue, descriptor.length);
+      value[descriptor.length - 1] = '\0';
+    }
+    else
+    {
+      memset(value, 0, descriptor.length);
+    }
+    value += descriptor.length;
+  }
+
+  ParameterGroup::applyDefaultValue();
+}
+
+int CompactParameterGroup::getStorageSize()
+{
+  return this->getValuesLength() + ParameterGroup::getStorageSize();
+}
+
+void CompactParameterGroup::storeValueTo(Serializer& serializer)
+{
+  // -- Values follow each other in the buffer, just as in the EEPROM.
+  SerializationData serializationData;
+  serializationData.length = this->getValuesLength();
+  serializationData.data = (byte*)this->_valueBuffer;
+  serializer.serialize(&serializationData);
+
+  // -- Store other items.
+  ParameterGroup::storeValueTo(serializer);
+}
+void CompactParameterGroup::loadValueFrom(Serializer& serializer)
+{
+  SerializationData serializationData;
+  serializationData.length = this->getValuesLength();
+  serializationData.data = (byte*)this->_valueBuffer;
+  serializer.serialize(&serializationData);
+
+  // -- Load other items.
+  ParameterGroup::loadValueFrom(serializer);
+}
+
+void CompactParameterGroup::renderHtml(
+  bool dataArrived, WebRequestWrapper* webRequestWrapper)
+{
+  if (this->label != nullptr)
+  {
+    String content = getStartTemplate();
+    content.replace("{b}", this->label);
+    content.replace("{i}", this->getId());
+    webRequestWrapper->sendContent(content);
+  }
+
+  CompactParameterDescriptor descriptor;
+  char parLength[12];
+  const char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    String id = String(FPSTR(descriptor.id));
+    String type = String(FPSTR(descriptor.type));
+    bool password = type.equals("password");
+
+    String pitem = getHtmlTemplate();
+    pitem.replace("{b}", String(FPSTR(descriptor.label)));
+    pitem.replace("{t}", type);
+    pitem.replace("{i}", id);
+    pitem.replace("{p}", descriptor.placeholder == nullptr ?
+      String("") : String(FPSTR(descriptor.placeholder)));
+    snprintf(parLength, 12, "%d", descriptor.length - 1);
+    pitem.replace("{l}", parLength);
+    if (password)
+    {
+      pitem.replace("{v}", "");
+    }
+    else if (dataArrived && webRequestWrapper->hasArg(id))
+    {
+      // -- Value from previous submit
+      pitem.replace("{v}", webRequestWrapper->arg(id));
+    }
+    else
+    {
+      // -- Value from config
+      pitem.replace("{v}", value);
+    }
+    pitem.replace("{c}", descriptor.customHtml == nullptr ?
+      String("") : String(FPSTR(descriptor.customHtml)));
+    const char* errorMessage = nullptr;
+    for (byte e = 0; e < this->_errorCount; e++)
+    {
+      if (this->_errors[e].index == i)
+      {
+        errorMessage = this->_errors[e].message;
+      }
+    }
+    pitem.replace("{s}", errorMessage != nullptr ? "de" : ""); // Div style class.
+    pitem.replace("{e}", errorMessage != nullptr ? errorMessage : "");
+    webRequestWrapper->sendContent(pitem);
+
+    value += descriptor.length;
+  }
+
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    if (current->visible)
+    {
+      current->renderHtml(dataArrived, webRequestWrapper);
+    }
+    current = this->getNextItemOf(current);
+  }
+
+  if (this->label != nullptr)
+  {
+    String content = getEndTemplate();
+    content.replace("{b}", this->label);
+    content.replace("{i}", this->getId());
+    webRequestWrapper->sendContent(content);
+  }
+}
+
+void CompactParameterGroup::updateValue(
+  const CompactParameterDescriptor* descriptor, char* value, String newValue)
+{
+  if ((newValue.length() == 0) &&
+    (strcmp_P("password", descriptor->type) == 0))
+  {
+    // -- Password was not changed.
+    return;
+  }
+  newValue.toCharArray(value, descriptor->length);
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+  Serial.print(FPSTR(descriptor->id));
+  Serial.print(": ");
+  Serial.println(value);
+#endif
+}
+
+void CompactParameterGroup::update(WebRequestWrapper* webRequestWrapper)
+{
+  CompactParameterDescriptor descriptor;
+  char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    String id = String(FPSTR(descriptor.id));
+    if (webRequestWrapper->hasArg(id))
+    {
+      this->updateValue(&descriptor, value, webRequestWrapper->arg(id));
+    }
+    value += descriptor.length;
+  }
+
+  // -- Update other items.
+  ParameterGroup::update(webRequestWrapper);
+}
+
+#ifdef IOTWEBCONF_ENABLE_JSON
+void CompactParameterGroup::loadFromJson(JsonObject jsonObject)
+{
+  CompactParameterDescriptor descriptor;
+  char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    String id = String(FPSTR(descriptor.id));
+    if (jsonObject.containsKey(id.c_str()))
+    {
+      const char* jsonValue = jsonObject[id.c_str()];
+      this->updateValue(&descriptor, value, String(jsonValue));
+    }
+    value += descriptor.length;
+  }
+
+  // -- Load other items.
+  ParameterGroup::loadFromJson(jsonObject);
+}
+#endif
+
+bool CompactParameterGroup::loadJsonValue(const char* id, const String& value)
+{
+  int index = this->indexOf(id);
+  if (index < 0)
+  {
+    return ParameterGroup::loadJsonValue(id, value);
+  }
+  CompactParameterDescriptor descriptor;
+  this->readDescriptor(index, &descriptor);
+  this->updateValue(&descriptor, this->getValue(index), value);
+  return true;
+}
+
+void CompactParameterGroup::writeJson(JsonWriter* writer)
+{
+  writer->beginObject(this->getId());
+  CompactParameterDescriptor descriptor;
+  const char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    String id = String(FPSTR(descriptor.id));
+    if (strcmp_P("password", descriptor.type) == 0)
+    {
+      writer->passwordValue(id.c_str(), value);
+    }
+    else
+    {
+      writer->value(id.c_str(), value);
+    }
+    value += descriptor.length;
+  }
+
+  // -- Write other items.
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    current->writeJson(writer);
+    current = this->getNextItemOf(current);
+  }
+  writer->endObject();
+}
+
+void CompactParameterGroup::clearErrorMessage()
+{
+  this->_errorCount = 0;
+  ParameterGroup::clearErrorMessage();
+}
+
+void CompactParameterGroup::debugTo(Stream* out)
+{
+  out->print('[');
+  out->print(this->getId());
+  out->println(']');
+
+  CompactParameterDescriptor descriptor;
+  const char* value = this->_valueBuffer;
+  for (byte i = 0; i < this->_count; i++)
+  {
+    this->readDescriptor(i, &descriptor);
+    out->print(
+      ((i + 1 == this->_count) && (this->_firstItem == nullptr)) ?
+        "\\-- " : "|-- ");
+    out->print("'");
+    out->print(FPSTR(descriptor.id));
+    out->print("' with value: ");
+#ifndef IOTWEBCONF_DEBUG_PWD_TO_SERIAL
+    if (strcmp_P("password", descriptor.type) == 0)
+    {
+      out->println(F("<hidden>"));
+    }
+    else
+#endif
+    {
+      out->print("'");
+      out->print(value);
+      out->println("'");
+    }
+    value += descriptor.length;
+  }
+
+  // -- Print other items.
+  if (this->_firstItem != nullptr)
+  {
+    ParameterGroup::debugTo(out);
+  }
+}
+
+size_t CompactParameterGroup::memoryReportTo(Stream* out)
+{
+  size_t ram = ConfigItem::memoryReportTo(out);
+  // -- Each parameter only takes its value in RAM.
+  for (byte i = 0; i < this->_count; i++)
+  {
+    CompactParameterDescriptor descriptor;
+    this->readDescriptor(i, &descriptor);
+    out->print(FPSTR(descriptor.id));
+    out->print(": RAM ");
+    out->print(descriptor.length);
+    out->print(", EEPROM ");
+    out->println(descriptor.length);
+    ram += descriptor.length;
+  }
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    ram += current->memoryReportTo(out);
+    current = this->getNextItemOf(current);
+  }
+  return ram;
+}
+
+} // end namespace
@@ -0,0 +1,145 @@
+/**
+ * IotWebConfCompactGroup.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfCompactGroup_h
+#define IotWebConfCompactGroup_h
+
+#include "IotWebConfParameter.h"
+
+// -- Maximal number of parameters displaying an error at a time.
+#ifndef IOTWEBCONF_COMPACT_GROUP_MAX_ERRORS
+# define IOTWEBCONF_COMPACT_GROUP_MAX_ERRORS 4
+#endif
+
+namespace iotwebconf
+{
+
+/**
+ * Static metadata of a parameter in a CompactParameterGroup. Descriptors
+ * are meant to be placed in a PROGMEM table, and all the strings they point
+ * to should also be PROGMEM strings.
+ */
+typedef struct CompactParameterDescriptor
+{
+  const char* id;
+  const char* label;
+  const char* type;          // -- HTML input type, e.g. "text", "number", "password".
+  const char* defaultValue;  // -- Can be nullptr.
+  const char* placeholder;   // -- Can be nullptr.
+  const char* customHtml;    // -- Can be nullptr.
+  uint16_t length;           // -- Length of the value including the terminating zero.
+} CompactParameterDescriptor;
+
+/**
+ * A group of text based parameters, where the metadata of the parameters is
+ * read from a PROGMEM descriptor table. Only the values are kept in RAM, in a
+ * single buffer provided by the application, where the values follow each
+ * other in the order of the descriptors. Parameters are addressed by their
+ * index in the descriptor table.
+ * Storage layout is the same as that of a ParameterGroup with TextParameters
+ * of the same lengths. Parameters of "password" type are only updated, when
+ * a value was provided in the config portal.
+ * Error messages are kept for at most IOTWEBCONF_COMPACT_GROUP_MAX_ERRORS
+ * parameters at a time, further errors are not displayed (but still fail
+ * the validation).
+ * The parameters are not config items, but IotWebConf::findItem() returns
+ * the group for their ids, and values can be applied to them with
+ * IotWebConf::applyValue(). A Constraint can target a parameter with
+ * Constraint::setFieldId().
+ *
+ * Example:
+ *   const char mqttServerId[] PROGMEM = "mqttServer";
+ *   ...
+ *   const iotwebconf::CompactParameterDescriptor mqttDescriptors[] PROGMEM = {
+ *     { mqttServerId, mqttServerLabel, textType, nullptr, nullptr, nullptr, 32 },
+ *     { mqttPortId, mqttPortLabel, numberType, mqttPortDefault, nullptr, nullptr, 6 } };
+ *   char mqttValues[32 + 6];
+ *   iotwebconf::CompactParameterGroup mqttGroup(
+ *     "mqtt", "MQTT", mqttDescriptors, 2, mqttValues);
+ */
+class CompactParameterGroup : public ParameterGroup
+{
+public:
+  CompactParameterGroup(
+    const char* id, const char* label,
+    const CompactParameterDescriptor* descriptors, byte count,
+    char* valueBuffer);
+
+  byte getCount() { return this->_count; }
+  /**
+   * Returns the index of the parameter with the provided id, or -1.
+   */
+  int indexOf(const char* id);
+  /**
+   * Returns the value of the parameter with the provided index. The offset of
+   * the value is calculated from the descriptor table on every call, so it is
+   * recommended to keep the returned pointer, instead of calling this
+   * method repeatedly.
+   */
+  char* getValue(byte index);
+  /**
+   * Displays the message next to the parameter with the provided index, to
+   * be used in form validation.
+   */
+  void setErrorMessage(byte index, const char* errorMessage);
+  using ParameterGroup::setErrorMessage;
+  void setFieldErrorMessage(const char* id, const char* errorMessage) override;
+
+  void applyDefaultValue() override;
+#ifdef IOTWEBCONF_ENABLE_JSON
+  virtual void loadFromJson(JsonObject jsonObject) override;
+#endif
+  bool loadJsonValue(const char* id, const String& value) override;
+  void writeJson(JsonWriter* writer) override;
+
+protected:
+  int getStorageSize() override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
+  void renderHtml(bool dataArrived, WebRequestWrapper* webRequestWrapper) override;
+  void update(WebRequestWrapper* webRequestWrapper) override;
+  void clearErrorMessage() override;
+  void debugTo(Stream* out) override;
+  size_t getMemoryUsage() override { return sizeof(CompactParameterGroup); }
+  ConfigItem* findItem(const char* id) override;
+  bool addToIndex(ItemIndex* index) override;
+  const char* getFieldId(int field) override
+  {
+    return (const char*)pgm_read_ptr(&this->_descriptors[field].id);
+  }
+  size_t memoryReportTo(Stream* out) override;
+  /**
+   * One can override this method in case a specific HTML template is required
+   * for the parameters.
+   */
+  virtual String getHtmlTemplate() { return FPSTR(IOTWEBCONF_HTML_FORM_PARAM); };
+
+private:
+  const CompactParameterDescriptor* _descriptors;
+  byte _count;
+  char* _valueBuffer;
+  typedef struct Error
+  {
+    int16_t index;
+    const char* message;
+  } Error;
+  Error _errors[IOTWEBCONF_COMPACT_GROUP_MAX_ERRORS];
+  byte _errorCount = 0;
+
+  void readDescriptor(byte index, CompactParameterDescriptor* descriptor);
+  int getValuesLength();
+  void updateValue(
+    const CompactParameterDescriptor* descriptor, char* value, String newValue);
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * IotWebConfDnsResponder.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "IotWebConfDnsResponder.h"
+
+#define IOTWEBCONF_DNS_HEADER_SIZE 12
+#define IOTWEBCONF_DNS_TYPE_A 1
+#define IOTWEBCONF_DNS_TYPE_ANY 255
+#define IOTWEBCONF_DNS_TTL 60
+
+namespace iotwebconf
+{
+
+bool DnsResponder::start(uint16_t port, const IPAddress& resolvedIp)
+{
+  // -- Answer record: pointer to the name in the question, type A,
+  // class IN, TTL, length and the address.
+  const byte answer[16] = {
+    0xC0, IOTWEBCONF_DNS_HEADER_SIZE,
+    0x00, IOTWEBCONF_DNS_TYPE_A,
+    0x00, 0x01,
+    0x00, 0x00, 0x00, IOTWEBCONF_DNS_TTL,
+    0x00, 0x04,
+    resolvedIp[0], resolvedIp[1], resolvedIp[2], resolvedIp[3] };
+  memcpy(this->_answer, answer, sizeof(this->_answer));
+  return this->_udp.begin(port) == 1;
+}
+
+void DnsResponder::stop()
+{
+  this->_udp.stop();
+}
+
+void DnsResponder::processNextRequest()
+{
+  for (byte i = 0; i < this->_packetBudget; i++)
+  {
+    int packetSize = this->_udp.parsePacket();
+    if (packetSize <= 0)
+    {
+      return;
+    }
+    if (((size_t)packetSize > BufferSize) ||
+      (packetSize < IOTWEBCONF_DNS_HEADER_SIZE))
+    {
+      // -- Not a query we can answer, skip it.
+      continue;
+    }
+    this->_udp.read(this->_buffer, packetSize);
+    size_t replyLength = this->buildReply(packetSize);
+    if (replyLength > 0)
+    {
+      this->_udp.beginPacket(this->_udp.remoteIP(), this->_udp.remotePort());
+      this->_udp.write(this->_buffer, replyLength);
+      this->_udp.endPacket();
+    }
+  }
+}
+
+size_t DnsResponder::buildReply(size_t queryLength)
+{
+  byte* header = this->_buffer;
+  // -- Only standard queries (QR = 0, OPCODE = 0) with a single question.
+  if (((header[2] & 0xF8) != 0) ||
+    (header[4] != 0) || (header[5] != 1))
+  {
+    return 0;
+  }
+
+  // -- Skip the labels of the name.
+  size_t position = IOTWEBCONF_DNS_HEADER_SIZE;
+  while ((position < queryLength) && (this->_buffer[position] != 0))
+  {
+    if ((this->_buffer[position] & 0xC0) != 0)
+    {
+      // -- No compression is expected in a question.
+      return 0;
+    }
+    position += this->_buffer[position] + 1;
+  }
+  position += 5; // -- Terminating zero, type and class.
+  if ((position > queryLength) || (position + sizeof(this->_answer) > BufferSize))
+  {
+    return 0;
+  }
+  uint16_t type = (this->_buffer[position - 4] << 8) | this->_buffer[position - 3];
+
+  // -- Patch the header: response, authoritative, keep RD, no error. Any
+  // additional records of the query (e.g. EDNS) are dropped.
+  header[2] = 0x84 | (header[2] & 0x01);
+  header[3] = 0x00;
+  header[6] = 0;
+  header[7] = 0;
+  header[8] = 0;
+  header[9] = 0;
+  header[10] = 0;
+  header[11] = 0;
+  if ((type == IOTWEBCONF_DNS_TYPE_A) || (type == IOTWEBCONF_DNS_TYPE_ANY))
+  {
+    header[7] = 1;
+    memcpy(this->_buffer + position, this->_answer, sizeof(this->_answer));
+    position += sizeof(this->_answer);
+  }
+  return position;
+}
+
+} // end namespace
@@ -0,0 +1,60 @@
+/**
+ * IotWebConfDnsResponder.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfDnsResponder_h
+#define IotWebConfDnsResponder_h
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <WiFiUdp.h>
+#include "IotWebConfSettings.h"
+
+namespace iotwebconf
+{
+
+/**
+ * Minimal DNS responder for the captive portal, an alternative to DNSServer.
+ * All A queries are answered with the IP address provided on start, all other
+ * queries (e.g. AAAA, HTTPS) are answered with an empty reply.
+ * Each processNextRequest() call handles every pending query up to the packet
+ * budget. Replies are built in place from the query, only the header is
+ * patched and a precomputed answer record is appended.
+ */
+class DnsResponder
+{
+public:
+  DnsResponder(byte packetBudget = IOTWEBCONF_DNS_PACKET_BUDGET) :
+    _packetBudget(packetBudget) { }
+
+  bool start(uint16_t port, const IPAddress& resolvedIp);
+  void processNextRequest();
+  void stop();
+
+protected:
+  /**
+   * Turns the query in the buffer into a reply. Returns the length of the
+   * reply, or 0 if the packet is to be dropped.
+   */
+  virtual size_t buildReply(size_t queryLength);
+
+  // -- Header (12) + longest name (255) + type and class (4) + answer (16).
+  static const size_t BufferSize = 287;
+  byte _buffer[BufferSize];
+
+private:
+  WiFiUDP _udp;
+  byte _packetBudget;
+  byte _answer[16];
+};
+
+} // end namespace
+
+#endif
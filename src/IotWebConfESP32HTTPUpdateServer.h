@@ -26,11 +26,239 @@
 #include <WebServer.h>
 #include <StreamString.h>
 #include <Update.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/version.h>
+
+// -- mbedtls 3 dropped the _ret suffix of the SHA-256 functions.
+#if defined(MBEDTLS_VERSION_MAJOR) && (MBEDTLS_VERSION_MAJOR >= 3)
+# define IOTWEBCONF_SHA256_STARTS mbedtls_sha256_starts
+# define IOTWEBCONF_SHA256_UPDATE mbedtls_sha256_update
+# define IOTWEBCONF_SHA256_FINISH mbedtls_sha256_finish
+#else
+# define IOTWEBCONF_SHA256_STARTS mbedtls_sha256_starts_ret
+# define IOTWEBCONF_SHA256_UPDATE mbedtls_sha256_update_ret
+# define IOTWEBCONF_SHA256_FINISH mbedtls_sha256_finish_ret
+#endif
+
+#if __has_include(<esp32/rom/miniz.h>)
+# include <esp32/rom/miniz.h>
+# define IOTWEBCONF_UPDATE_GZIP
+#elif __has_include(<rom/miniz.h>)
+# include <rom/miniz.h>
+# define IOTWEBCONF_UPDATE_GZIP
+#endif
 
 #define emptyString F("")
 
+// -- Maximal size of a chunk with the resumable (chunked) upload.
+#ifndef IOTWEBCONF_UPDATE_CHUNK_SIZE
+# define IOTWEBCONF_UPDATE_CHUNK_SIZE 4096
+#endif
+
 class WebServer;
 
+#ifdef IOTWEBCONF_UPDATE_GZIP
+/**
+ * Inflates a gzip compressed image chunk by chunk, and writes the result
+ * to Update. The only buffer is the 32 kB window of deflate, that is
+ * allocated for the time of the upload.
+ */
+class HTTPUpdateInflater
+{
+  public:
+    static bool isGzip(const uint8_t* data, size_t length)
+    {
+        return (length >= 2) && (data[0] == 0x1f) && (data[1] == 0x8b);
+    }
+
+    bool begin()
+    {
+        _decompressor = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+        _window = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+        if (_decompressor == nullptr || _window == nullptr) {
+            end();
+            return false;
+        }
+        tinfl_init(_decompressor);
+        _state = Header;
+        _position = 0;
+        _skip = 0;
+        _flags = 0;
+        _windowPosition = 0;
+        _inflatedSize = 0;
+        _compressedSize = 0;
+        return true;
+    }
+
+    /**
+     * Returns false, if the data is not a valid gzip stream, or Update failed.
+     */
+    bool write(const uint8_t* data, size_t length)
+    {
+        _compressedSize += length;
+        while (length > 0) {
+            if (_state == Deflate) {
+                size_t consumed = length;
+                if (!_inflate(data, &consumed)) {
+                    return false;
+                }
+                data += consumed;
+                length -= consumed;
+            } else if (_state == Trailer) {
+                // -- CRC32 and the size of the original data.
+                if (_position >= sizeof(_trailer)) {
+                    return false;
+                }
+                _trailer[_position++] = *data++;
+                length--;
+            } else if (!_parseHeader(*data++)) {
+                return false;
+            } else {
+                length--;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Returns true, if the whole stream was inflated, and the size matches
+     * the one in the gzip trailer.
+     */
+    bool isComplete()
+    {
+        if (_state != Trailer || _position != sizeof(_trailer)) {
+            return false;
+        }
+        uint32_t size = _trailer[4] | (_trailer[5] << 8) |
+            (_trailer[6] << 16) | ((uint32_t)_trailer[7] << 24);
+        return size == (uint32_t)_inflatedSize;
+    }
+
+    void end()
+    {
+        free(_decompressor);
+        free(_window);
+        _decompressor = nullptr;
+        _window = nullptr;
+    }
+
+    size_t getCompressedSize() { return _compressedSize; }
+    size_t getInflatedSize() { return _inflatedSize; }
+
+  protected:
+    enum State { Header, Extra, Name, Comment, HeaderCrc, Deflate, Trailer };
+
+    bool _parseHeader(uint8_t b)
+    {
+        switch (_state) {
+            case Header:
+                // -- Magic, method (deflate), flags, time, extra flags, OS.
+                if ((_position == 0 && b != 0x1f) || (_position == 1 && b != 0x8b) ||
+                    (_position == 2 && b != 8)) {
+                    return false;
+                }
+                if (_position == 3) {
+                    _flags = b;
+                }
+                if (++_position == 10) {
+                    _position = 0;
+                    _nextHeaderState();
+                }
+                return true;
+            case Extra:
+                if (_position < 2) {
+                    _skip |= b << (8 * _position++);
+                } else {
+                    _skip--;
+                }
+                if (_position == 2 && _skip == 0) {
+                    _position = 0;
+                    _nextHeaderState();
+                }
+                return true;
+            case Name:
+            case Comment:
+                if (b == 0) {
+                    _nextHeaderState();
+                }
+                return true;
+            case HeaderCrc:
+                if (++_position == 2) {
+                    _position = 0;
+                    _nextHeaderState();
+                }
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void _nextHeaderState()
+    {
+        // -- FEXTRA (4), FNAME (8), FCOMMENT (16), FHCRC (2) follow each other in this order.
+        if (_state < Extra && (_flags & 4)) {
+            _state = Extra;
+            _skip = 0;
+        } else if (_state < Name && (_flags & 8)) {
+            _state = Name;
+        } else if (_state < Comment && (_flags & 16)) {
+            _state = Comment;
+        } else if (_state < HeaderCrc && (_flags & 2)) {
+            _state = HeaderCrc;
+        } else {
+            _state = Deflate;
+        }
+    }
+
+    bool _inflate(const uint8_t* data, size_t* length)
+    {
+        size_t available = *length;
+        while (true) {
+            size_t inSize = available;
+            size_t outSize = TINFL_LZ_DICT_SIZE - _windowPosition;
+            tinfl_status status = tinfl_decompress(
+                _decompressor, data, &inSize,
+                _window, _window + _windowPosition, &outSize,
+                TINFL_FLAG_HAS_MORE_INPUT);
+            data += inSize;
+            available -= inSize;
+            if (outSize > 0) {
+                if (Update.write(_window + _windowPosition, outSize) != outSize) {
+                    return false;
+                }
+                _inflatedSize += outSize;
+                _windowPosition = (_windowPosition + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+            }
+            if (status < TINFL_STATUS_DONE) {
+                return false;
+            }
+            if (status == TINFL_STATUS_DONE) {
+                _state = Trailer;
+                _position = 0;
+                break;
+            }
+            if (status == TINFL_STATUS_NEEDS_MORE_INPUT && available == 0) {
+                break;
+            }
+        }
+        *length -= available;
+        return true;
+    }
+
+  private:
+    tinfl_decompressor* _decompressor = nullptr;
+    uint8_t* _window = nullptr;
+    State _state;
+    size_t _position;
+    uint16_t _skip;
+    uint8_t _flags;
+    uint8_t _trailer[8];
+    size_t _windowPosition;
+    size_t _inflatedSize;
+    size_t _compressedSize;
+};
+#endif
+
 class HTTPUpdateServer
 {
   public:
@@ -41,6 +269,7 @@ class HTTPUpdateServer
         _username = emptyString;
         _password = emptyString;
         _authenticated = false;
+        mbedtls_sha256_init(&_sha256);
     }
 
 
@@ -67,7 +296,7 @@ class HTTPUpdateServer
 
       // handler for the /update form page
       _server->on(path.c_str(), HTTP_GET, [&](){
-          if(_username != emptyString && _password != emptyString && !_server->authenticate(_username.c_str(), _password.c_str()))
+          if(!_checkAuthentication())
               return _server->requestAuthentication();
           _server->send_P(200, PSTR("text/html"), serverIndex);
       });
@@ -76,11 +305,11 @@ class HTTPUpdateServer
       _server->on(path.c_str(), HTTP_POST, [&](){
           if(!_authenticated)
               return _server->requestAuthentication();
-          if (Update.hasError()) {
+          if (Update.hasError() || _updaterError.length()) {
               _server->send(200, F("text/html"), String(F("Update error: ")) + _updaterError);
           } else {
               _server->client().setNoDelay(true);
-              _server->send_P(200, PSTR("text/html"), successResponse);
+              _server->send(200, F("text/html"), String(successResponse) + _updateStats);
               delay(100);
               _server->client().stop();
               ESP.restart();
@@ -91,43 +320,149 @@ class HTTPUpdateServer
           HTTPUpload& upload = _server->upload();
 
           if(upload.status == UPLOAD_FILE_START){
-              _updaterError = String();
               if (_serial_output)
                   Serial.setDebugOutput(true);
 
-              _authenticated = (_username == emptyString || _password == emptyString || _server->authenticate(_username.c_str(), _password.c_str()));
+              _authenticated = _checkAuthentication();
               if(!_authenticated){
                   if (_serial_output)
                       Serial.printf("Unauthenticated Update\n");
                   return;
               }
 
+              // -- Only an authenticated upload may replace the one in progress.
+              _updaterError = String();
+              _releaseChunked();
+              if (Update.isRunning())
+                  Update.abort();
+
   ///        WiFiUDP::stopAll();
               if (_serial_output)
                   Serial.printf("Update: %s\n", upload.filename.c_str());
-  ///        uint32_t maxSketchSpace = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
-  ///        if(!Update.begin(maxSketchSpace)){//start with max available size
-              if(!Update.begin(UPDATE_SIZE_UNKNOWN)){//start with max available size
-                  _setUpdaterError();
-              }
+              _beginImage();
           } else if(_authenticated && upload.status == UPLOAD_FILE_WRITE && !_updaterError.length()){
-              if (_serial_output) Serial.printf(".");
-              if(Update.write(upload.buf, upload.currentSize) != upload.currentSize){
-                  _setUpdaterError();
-              }
+              _writeImage(upload.buf, upload.currentSize);
           } else if(_authenticated && upload.status == UPLOAD_FILE_END && !_updaterError.length()){
-              if(Update.end(true)){ //true to set the size to the current progress
-                  if (_serial_output) Serial.printf("Update Success: %u\nRebooting...\n", upload.totalSize);
-              } else {
-                  _setUpdaterError();
+              if (_endImage()) {
+                  if (_serial_output) Serial.printf("Update Success: %s\nRebooting...\n", _updateStats.c_str());
               }
               if (_serial_output) Serial.setDebugOutput(false);
           } else if(_authenticated && upload.status == UPLOAD_FILE_ABORTED){
               Update.end();
               if (_serial_output) Serial.println("Update was aborted");
           }
+          if (_authenticated && (upload.status == UPLOAD_FILE_END || upload.status == UPLOAD_FILE_ABORTED)) {
+              _releaseImage();
+          }
           delay(0);
       });
+
+      // -- Resumable upload: begin, chunks (in order, each with a CRC32),
+      // status query for resuming, and end.
+      _server->on((path + "/begin").c_str(), HTTP_POST, [&](){
+          if(!_checkAuthentication())
+              return _server->requestAuthentication();
+          _releaseChunked();
+          if (Update.isRunning())
+              Update.abort();
+          _updaterError = String();
+          size_t size = _server->hasArg("size") ? (size_t)_server->arg("size").toInt() : 0;
+          if (size == 0) {
+              return _sendChunkedStatus(400, F("Missing image size."));
+          }
+          _chunk = (uint8_t*)malloc(IOTWEBCONF_UPDATE_CHUNK_SIZE);
+          if (_chunk == nullptr) {
+              return _sendChunkedStatus(500, F("Not enough memory."));
+          }
+          if (!_beginImage()) {
+              _releaseChunked();
+              return _sendChunkedStatus(500, _updaterError);
+          }
+          _chunkedSize = size;
+          _sendChunkedStatus(200, emptyString);
+      });
+
+      _server->on((path + "/chunk").c_str(), HTTP_POST, [&](){
+          // -- The received chunk is consumed by this request, whatever the
+          // outcome, so a following request can not write it again.
+          size_t chunkLength = _chunkLength;
+          String chunkError = _chunkError;
+          _chunkLength = 0;
+          _chunkError = String();
+          if(!_checkAuthentication())
+              return _server->requestAuthentication();
+          if (_chunkedSize == 0 || _updaterError.length()) {
+              return _sendChunkedStatus(409, _updaterError.length() ? _updaterError : String(F("No upload in progress.")));
+          }
+          if (chunkError.length()) {
+              return _sendChunkedStatus(400, chunkError);
+          }
+          if (chunkLength == 0) {
+              return _sendChunkedStatus(400, F("Missing chunk data."));
+          }
+          size_t offset = (size_t)_server->arg("offset").toInt();
+          if (offset + chunkLength <= _receivedSize) {
+              // -- Chunk was already received (e.g. the response was lost).
+              return _sendChunkedStatus(200, emptyString);
+          }
+          if (offset != _receivedSize || offset + chunkLength > _chunkedSize) {
+              // -- Chunks must follow each other, as the image is written in order.
+              return _sendChunkedStatus(409, F("Unexpected offset."));
+          }
+          uint32_t crc = strtoul(_server->arg("crc32").c_str(), nullptr, 16);
+          if (crc != _crc32(_chunk, chunkLength)) {
+              return _sendChunkedStatus(400, F("CRC32 mismatch."));
+          }
+          if (!_writeImage(_chunk, chunkLength)) {
+              return _sendChunkedStatus(500, _updaterError);
+          }
+          _sendChunkedStatus(200, emptyString);
+      },[&](){
+          HTTPUpload& upload = _server->upload();
+          if(upload.status == UPLOAD_FILE_START){
+              _authenticated = _checkAuthentication();
+              _chunkLength = 0;
+              _chunkError = String();
+          } else if(_authenticated && upload.status == UPLOAD_FILE_WRITE && _chunk != nullptr){
+              if (_chunkLength + upload.currentSize > IOTWEBCONF_UPDATE_CHUNK_SIZE) {
+                  _chunkError = F("Chunk is too large.");
+              } else {
+                  memcpy(_chunk + _chunkLength, upload.buf, upload.currentSize);
+                  _chunkLength += upload.currentSize;
+              }
+          } else if(upload.status == UPLOAD_FILE_ABORTED){
+              // -- Partial chunk is dropped, the client can send it again.
+              _chunkError = F("Chunk upload aborted.");
+          }
+      });
+
+      _server->on((path + "/status").c_str(), HTTP_GET, [&](){
+          if(!_checkAuthentication())
+              return _server->requestAuthentication();
+          _sendChunkedStatus(200, _updaterError);
+      });
+
+      _server->on((path + "/end").c_str(), HTTP_POST, [&](){
+          if(!_checkAuthentication())
+              return _server->requestAuthentication();
+          if (_chunkedSize == 0 || _updaterError.length()) {
+              return _sendChunkedStatus(409, _updaterError.length() ? _updaterError : String(F("No upload in progress.")));
+          }
+          if (_receivedSize != _chunkedSize) {
+              return _sendChunkedStatus(409, F("Image is not complete."));
+          }
+          bool success = _endImage();
+          _releaseImage();
+          _releaseChunked();
+          if (!success) {
+              return _sendChunkedStatus(500, _updaterError);
+          }
+          _server->client().setNoDelay(true);
+          _server->send(200, F("application/json"), String(F("{\"result\":\"")) + _updateStats + F("\"}"));
+          delay(100);
+          _server->client().stop();
+          ESP.restart();
+      });
     }
 
     void updateCredentials(const String& username, const String& password)
@@ -137,6 +472,165 @@ class HTTPUpdateServer
     }
 
   protected:
+    bool _checkAuthentication()
+    {
+        return _username == emptyString || _password == emptyString ||
+            _server->authenticate(_username.c_str(), _password.c_str());
+    }
+
+    bool _beginImage()
+    {
+        _receivedSize = 0;
+        _uploadStartMs = millis();
+        _updateStats = String();
+        _gzip = false;
+        mbedtls_sha256_init(&_sha256);
+        IOTWEBCONF_SHA256_STARTS(&_sha256, 0);
+
+        // -- Expected digest is taken from the query string (e.g.
+        // "/firmware?sha256=..."), as form fields are not yet parsed
+        // when the upload starts.
+        _expectedDigest = _server->hasArg("sha256") ? _server->arg("sha256") : String();
+        _expectedDigest.toLowerCase();
+        if (_expectedDigest.length() && _expectedDigest.length() != 64) {
+            _updaterError = F("Invalid SHA-256 digest.");
+            return false;
+        }
+  ///        uint32_t maxSketchSpace = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
+  ///        if(!Update.begin(maxSketchSpace)){//start with max available size
+        if(!Update.begin(UPDATE_SIZE_UNKNOWN)){//start with max available size
+            _setUpdaterError();
+            return false;
+        }
+        return true;
+    }
+
+    bool _writeImage(uint8_t* data, size_t length)
+    {
+        IOTWEBCONF_SHA256_UPDATE(&_sha256, data, length);
+        bool firstChunk = (_receivedSize == 0);
+        _receivedSize += length;
+#ifdef IOTWEBCONF_UPDATE_GZIP
+        if (firstChunk && HTTPUpdateInflater::isGzip(data, length)) {
+            _gzip = _inflater.begin();
+            if (!_gzip) {
+                Update.abort();
+                _updaterError = F("Not enough memory to inflate the image.");
+                return false;
+            }
+        }
+        if (_gzip) {
+            if (!_inflater.write(data, length)) {
+                if (Update.hasError()) {
+                    _setUpdaterError();
+                } else {
+                    Update.abort();
+                    _updaterError = F("Invalid gzip data.");
+                }
+                return false;
+            }
+            return true;
+        }
+#endif
+        if(Update.write(data, length) != length){
+            _setUpdaterError();
+            return false;
+        }
+        return true;
+    }
+
+    bool _endImage()
+    {
+        if (_expectedDigest.length() && !_checkDigest()) {
+            // -- Reject the image before it would be activated.
+            Update.abort();
+            _updaterError = F("SHA-256 digest mismatch.");
+        }
+#ifdef IOTWEBCONF_UPDATE_GZIP
+        else if (_gzip && !_inflater.isComplete()) {
+            Update.abort();
+            _updaterError = F("Incomplete gzip data.");
+        }
+#endif
+        else if(Update.end(true)){ //true to set the size to the current progress
+            _setUpdateStats();
+            return true;
+        } else {
+            _setUpdaterError();
+            return false;
+        }
+        if (_serial_output) Serial.println(_updaterError);
+        return false;
+    }
+
+    void _releaseImage()
+    {
+        mbedtls_sha256_free(&_sha256);
+#ifdef IOTWEBCONF_UPDATE_GZIP
+        _inflater.end();
+#endif
+    }
+
+    void _releaseChunked()
+    {
+        if (_chunkedSize > 0) {
+            _releaseImage();
+        }
+        free(_chunk);
+        _chunk = nullptr;
+        _chunkedSize = 0;
+    }
+
+    void _sendChunkedStatus(int code, const String& error)
+    {
+        String status = String(F("{\"size\":")) + _chunkedSize +
+            F(",\"received\":") + _receivedSize;
+        if (error.length()) {
+            status += String(F(",\"error\":\"")) + error + '"';
+        }
+        status += '}';
+        _server->send(code, F("application/json"), status);
+    }
+
+    static uint32_t _crc32(const uint8_t* data, size_t length)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    bool _checkDigest()
+    {
+        unsigned char digest[32];
+        IOTWEBCONF_SHA256_FINISH(&_sha256, digest);
+        char hex[65];
+        for (int i = 0; i < 32; i++) {
+            snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+        }
+        return _expectedDigest.equals(hex);
+    }
+
+    void _setUpdateStats()
+    {
+        unsigned long elapsedMs = millis() - _uploadStartMs;
+        _updateStats = String(F("Received ")) + _receivedSize + F(" bytes");
+#ifdef IOTWEBCONF_UPDATE_GZIP
+        if (_gzip) {
+            _updateStats += String(F(", inflated to ")) + _inflater.getInflatedSize() + F(" bytes");
+        }
+#endif
+        if (elapsedMs > 0) {
+            // -- Bytes per millisecond is about kB/s.
+            _updateStats += String(F(" (")) + (unsigned long)(_receivedSize / elapsedMs) + F(" kB/s)");
+        }
+        _updateStats += '.';
+    }
+
     void _setUpdaterError()
     {
         if (_serial_output) Update.printError(Serial);
@@ -152,9 +646,25 @@ class HTTPUpdateServer
     String _password;
     bool _authenticated;
     String _updaterError;
+    String _expectedDigest;
+    mbedtls_sha256_context _sha256;
+    size_t _receivedSize = 0;
+    unsigned long _uploadStartMs = 0;
+    String _updateStats;
+    bool _gzip = false;
+#ifdef IOTWEBCONF_UPDATE_GZIP
+    HTTPUpdateInflater _inflater;
+#endif
+    // -- Resumable upload state, kept between the requests.
+    size_t _chunkedSize = 0;
+    uint8_t* _chunk = nullptr;
+    size_t _chunkLength = 0;
+    String _chunkError;
     const char* serverIndex PROGMEM =
-R"(<html><body><form method='POST' action='' enctype='multipart/form-data'>
+R"(<html><body><form method='POST' action='' enctype='multipart/form-data'
+                  onsubmit="var d=document.getElementById('sha256').value.trim(); this.action=d?'?sha256='+d:'';">
                   <input type='file' name='update'>
+                  <input type='text' id='sha256' placeholder='SHA-256 (optional)'>
                   <input type='submit' value='Update'>
                </form>
          </body></html>)";
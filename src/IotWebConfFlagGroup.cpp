@@ -0,0 +1,119 @@
+/**
+ * IotWebConfFlagGroup.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "IotWebConfFlagGroup.h"
+
+namespace iotwebconf
+{
+
+bool FlagCheckboxTParameter::update(String newValue, bool validateOnly)
+{
+  if (!validateOnly)
+  {
+    this->setChecked(
+      newValue.equals("selected") || newValue.equals("1") || newValue.equals("true"));
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int FlagGroup::getFlagCount()
+{
+  int count = 0;
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    if (current->isFlag())
+    {
+      count++;
+    }
+    current = current->_nextItem;
+  }
+  return count;
+}
+
+int FlagGroup::getStorageSize()
+{
+  int size = ParameterGroup::getStorageSize();
+  if (this->packsFlags())
+  {
+    size += (this->getFlagCount() + 7) / 8;
+  }
+  return size;
+}
+
+void FlagGroup::storeValueTo(Serializer& serializer)
+{
+  if (this->packsFlags())
+  {
+    // -- Store flags, eight in a byte, lowest bits first.
+    byte data[1] = { 0 };
+    SerializationData serializationData;
+    serializationData.length = 1;
+    serializationData.data = data;
+    byte bit = 0;
+    ConfigItem* current = this->_firstItem;
+    while (current != nullptr)
+    {
+      if (current->isFlag())
+      {
+        data[0] |= (byte)current->getFlagValue() << bit;
+        if (++bit == 8)
+        {
+          serializer.serialize(&serializationData);
+          data[0] = 0;
+          bit = 0;
+        }
+      }
+      current = current->_nextItem;
+    }
+    if (bit > 0)
+    {
+      serializer.serialize(&serializationData);
+    }
+  }
+
+  // -- Store other items.
+  ParameterGroup::storeValueTo(serializer);
+}
+
+void FlagGroup::loadValueFrom(Serializer& serializer)
+{
+  if (this->packsFlags())
+  {
+    // -- Load flags.
+    byte data[1] = { 0 };
+    SerializationData serializationData;
+    serializationData.length = 1;
+    serializationData.data = data;
+    byte bit = 0;
+    ConfigItem* current = this->_firstItem;
+    while (current != nullptr)
+    {
+      if (current->isFlag())
+      {
+        if (bit == 0)
+        {
+          serializer.serialize(&serializationData);
+        }
+        current->setFlagValue((data[0] >> bit) & 1);
+        bit = (bit + 1) % 8;
+      }
+      current = current->_nextItem;
+    }
+  }
+
+  // -- Load other items.
+  ParameterGroup::loadValueFrom(serializer);
+}
+
+} // end namespace
@@ -0,0 +1,85 @@
+/**
+ * IotWebConfFlagGroup.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfFlagGroup_h
+#define IotWebConfFlagGroup_h
+
+#include "IotWebConfTParameter.h"
+
+namespace iotwebconf
+{
+
+/**
+ * Checkbox parameter with its value accessible by isChecked() and
+ * setChecked(). It is a CheckboxTParameter, so placed in a FlagGroup its
+ * value takes a single bit of the storage.
+ */
+class FlagCheckboxTParameter : public CheckboxTParameter
+{
+public:
+  FlagCheckboxTParameter(const char* id, const char* label, const bool defaultValue) :
+    ConfigItemBridge(id),
+    CheckboxTParameter::CheckboxTParameter(id, label, defaultValue) { }
+
+  void setChecked(bool checked) { this->_value = checked; }
+
+protected:
+  virtual bool update(String newValue, bool validateOnly = false) override;
+};
+
+/**
+ * Parameter group, where the values of the checkbox items (CheckboxParameter,
+ * CheckboxTParameter, FlagCheckboxTParameter) and the active flags of the
+ * OptionalParameterGroup items are stored in a shared bitfield: 8 flags take
+ * a single byte in the storage. Only the direct sub-items are packed, other
+ * items (and the sub-items of groups) are stored as usual. The bitfield is
+ * stored before the other items of the group.
+ *
+ * A group replacing a ParameterGroup of the same items can still read the
+ * previous layout, see setLegacyLayout().
+ */
+class FlagGroup : public ParameterGroup
+{
+public:
+  FlagGroup(const char* id, const char* label = nullptr) :
+    ParameterGroup(id, label) { }
+
+  /**
+   * Add a checkbox to the group. Same as addItem(), any item with a flag
+   *   added to the group is packed.
+   */
+  void addFlag(ConfigItem* checkbox) { this->addItem(checkbox); }
+
+  /**
+   * Number of the packed flags.
+   */
+  int getFlagCount();
+
+  /**
+   * With legacy layout, the group stores every item the way a ParameterGroup
+   *   does (e.g. a byte per CheckboxTParameter). Use it for migrating a
+   *   stored config, see IotWebConf::setLegacyConfigVersion().
+   */
+  void setLegacyLayout(bool legacyLayout) { this->_legacyLayout = legacyLayout; }
+
+protected:
+  int getStorageSize() override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
+  bool packsFlags() override { return !this->_legacyLayout; }
+
+private:
+  bool _legacyLayout = false;
+};
+
+} // end namespace
+
+#endif
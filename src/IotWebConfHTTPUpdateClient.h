@@ -0,0 +1,550 @@
+/**
+ * IotWebConfHTTPUpdateClient.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfHTTPUpdateClient_h
+#define IotWebConfHTTPUpdateClient_h
+
+#include <Arduino.h>
+#include <functional>
+#include "IotWebConfSettings.h"
+#include <WiFiClient.h>
+#ifdef ESP8266
+# include <Updater.h>
+# include <bearssl/bearssl_hash.h>
+#elif defined(ESP32)
+# include <Update.h>
+# include <mbedtls/sha256.h>
+# include <mbedtls/version.h>
+// -- mbedtls 3 dropped the _ret suffix of the SHA-256 functions.
+# if defined(MBEDTLS_VERSION_MAJOR) && (MBEDTLS_VERSION_MAJOR >= 3)
+#  define IOTWEBCONF_SHA256_STARTS mbedtls_sha256_starts
+#  define IOTWEBCONF_SHA256_UPDATE mbedtls_sha256_update
+#  define IOTWEBCONF_SHA256_FINISH mbedtls_sha256_finish
+# else
+#  define IOTWEBCONF_SHA256_STARTS mbedtls_sha256_starts_ret
+#  define IOTWEBCONF_SHA256_UPDATE mbedtls_sha256_update_ret
+#  define IOTWEBCONF_SHA256_FINISH mbedtls_sha256_finish_ret
+# endif
+#endif
+
+namespace iotwebconf
+{
+
+/**
+ * Pull based firmware update. The client periodically downloads a small
+ * manifest from a HTTP server, and when the manifest announces a newer
+ * version than the running one, it downloads and flashes the firmware image.
+ * Every doLoop() call does only a small step (sending a request, reading
+ * the available part of a response), so the device keeps operating while
+ * the manifest is checked and the image is downloaded. (Only opening the
+ * connection is blocking.) After a successful update the device is
+ * restarted.
+ * Only plain http:// URLs are supported. The image response must have a
+ * Content-Length matching the size in the manifest.
+ *
+ * The manifest is a plain text file with "key=value" lines:
+ *   version=1.2.0
+ *   size=412345
+ *   sha256=<64 hex digits of the image digest>
+ *   url=http://192.168.1.10:8000/firmware-1.2.0.bin
+ * Versions are compared by their dot separated numeric parts.
+ *
+ * Use it with IotWebConf::setupUpdateClient(), so that it is only active,
+ * while the WiFi connection is up:
+ *   iotwebconf::HTTPUpdateClient updateClient("1.1.0");
+ *   ...
+ *   updateClient.setManifestUrl("http://192.168.1.10:8000/manifest.txt");
+ *   iotWebConf.setupUpdateClient([]() { updateClient.doLoop(); });
+ */
+class HTTPUpdateClient
+{
+public:
+  /**
+   * @currentVersion - Version of the running firmware.
+   */
+  HTTPUpdateClient(const char* currentVersion) :
+    _currentVersion(currentVersion) { }
+
+  /**
+   * The manifest URL is not copied, so it can be the value buffer of a
+   * parameter. An empty URL disables the update client.
+   */
+  void setManifestUrl(const char* manifestUrl) { this->_manifestUrl = manifestUrl; }
+  void setCheckInterval(unsigned long checkIntervalMs) { this->_checkIntervalMs = checkIntervalMs; }
+  /**
+   * Called when a newer version is found. Return false to skip the update
+   * this time (e.g. the device is busy), it will be offered again with the
+   * next check.
+   */
+  void setUpdateStartingCallback(std::function<bool(const char* newVersion)> func)
+  {
+    this->_updateStartingCallback = func;
+  }
+  /**
+   * Check the manifest with the next doLoop() call, regardless of the interval.
+   */
+  void checkNow() { this->_checkRequested = true; }
+  bool isUpdating() { return this->_state >= StateImageHeaders; }
+  /**
+   * Returns a description of the last failure, or an empty string.
+   */
+  const String& getLastError() { return this->_lastError; }
+
+  /**
+   * Should be called regularly, only while WiFi is connected. Performs the
+   * next step of the manifest check or the download.
+   */
+  void doLoop()
+  {
+    switch (this->_state)
+    {
+      case StateIdle:
+        if (this->_checkRequested ||
+          (millis() - this->_lastCheckMs >= this->_checkIntervalMs))
+        {
+          this->_checkRequested = false;
+          this->_lastCheckMs = millis();
+          if ((this->_manifestUrl != nullptr) && (this->_manifestUrl[0] != '\0'))
+          {
+            this->requestManifest();
+          }
+        }
+        break;
+      case StateManifestHeaders:
+      case StateImageHeaders:
+        this->readHeaders();
+        break;
+      case StateManifestBody:
+        this->readManifest();
+        break;
+      case StateDownloading:
+        this->downloadStep();
+        break;
+    }
+  }
+
+  /**
+   * Returns negative, zero or positive, when version a is older, the same,
+   * or newer than version b.
+   */
+  static int compareVersions(const char* a, const char* b)
+  {
+    while ((*a != '\0') || (*b != '\0'))
+    {
+      char* endA;
+      char* endB;
+      long partA = strtol(a, &endA, 10);
+      long partB = strtol(b, &endB, 10);
+      if (partA != partB)
+      {
+        return partA < partB ? -1 : 1;
+      }
+      if ((endA == a) && (endB == b))
+      {
+        // -- Not numeric, compare the rest as text.
+        return strcmp(a, b);
+      }
+      a = (*endA == '.') ? endA + 1 : endA;
+      b = (*endB == '.') ? endB + 1 : endB;
+    }
+    return 0;
+  }
+
+protected:
+  typedef enum State
+  {
+    StateIdle,
+    StateManifestHeaders,
+    StateManifestBody,
+    StateImageHeaders,
+    StateDownloading
+  } State;
+
+  void requestManifest()
+  {
+    if (!this->sendRequest(String(this->_manifestUrl)))
+    {
+      this->fail(F("Manifest server not available."));
+      return;
+    }
+    this->_manifest = String();
+    this->_state = StateManifestHeaders;
+  }
+
+  /**
+   * Connects to the server of the URL, and sends a GET request. The response
+   * is processed by the following doLoop() calls.
+   */
+  bool sendRequest(const String& url)
+  {
+    if (!url.startsWith("http://"))
+    {
+      return false;
+    }
+    int pathStart = url.indexOf('/', 7);
+    if (pathStart < 0)
+    {
+      pathStart = url.length();
+    }
+    String host = url.substring(7, pathStart);
+    uint16_t port = 80;
+    int colon = host.indexOf(':');
+    if (colon >= 0)
+    {
+      port = host.substring(colon + 1).toInt();
+      host = host.substring(0, colon);
+    }
+
+    this->_client.stop();
+    if (!this->_client.connect(host.c_str(), port))
+    {
+      return false;
+    }
+    // -- HTTP/1.0 is requested, so the response is not chunked.
+    this->_client.print("GET ");
+    this->_client.print(pathStart < (int)url.length() ? url.substring(pathStart) : String("/"));
+    this->_client.print(" HTTP/1.0\r\nHost: ");
+    this->_client.print(host);
+    this->_client.print("\r\nConnection: close\r\n\r\n");
+
+    this->_statusCode = 0;
+    this->_contentLength = -1;
+    this->_line = String();
+    this->_lastDataMs = millis();
+    return true;
+  }
+
+  /**
+   * Reads the status line and the headers, as long as data is available.
+   */
+  void readHeaders()
+  {
+    int budget = IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE;
+    while ((budget-- > 0) && (this->_client.available() > 0))
+    {
+      char c = this->_client.read();
+      this->_lastDataMs = millis();
+      if (c == '\r')
+      {
+        continue;
+      }
+      if (c != '\n')
+      {
+        if (this->_line.length() < IOTWEBCONF_UPDATE_CLIENT_MAX_LINE_LEN)
+        {
+          this->_line += c;
+        }
+        continue;
+      }
+      if (this->_line.length() == 0)
+      {
+        this->headersReceived();
+        return;
+      }
+      if (this->_statusCode == 0)
+      {
+        // -- E.g. "HTTP/1.1 200 OK"
+        this->_statusCode = this->_line.substring(this->_line.indexOf(' ') + 1).toInt();
+      }
+      else if (this->_line.substring(0, 15).equalsIgnoreCase("Content-Length:"))
+      {
+        String value = this->_line.substring(15);
+        value.trim();
+        this->_contentLength = value.toInt();
+      }
+      this->_line = String();
+    }
+    this->checkConnection(F("No response from the server."));
+  }
+
+  void headersReceived()
+  {
+    if (this->_state == StateManifestHeaders)
+    {
+      if (this->_statusCode != 200)
+      {
+        this->fail(String(F("Manifest download failed: ")) + this->_statusCode);
+        return;
+      }
+      this->_state = StateManifestBody;
+      return;
+    }
+
+    if (this->_statusCode != 200)
+    {
+      this->fail(String(F("Firmware download failed: ")) + this->_statusCode);
+      return;
+    }
+    if ((this->_contentLength < 0) || ((size_t)this->_contentLength != this->_size))
+    {
+      this->fail(F("Firmware size does not match the manifest."));
+      return;
+    }
+    if (!Update.begin(this->_size))
+    {
+      this->fail(F("Not enough space for the firmware."));
+      return;
+    }
+    this->_received = 0;
+    this->shaBegin();
+    this->_state = StateDownloading;
+  }
+
+  void readManifest()
+  {
+    int budget = IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE;
+    while ((budget-- > 0) && (this->_client.available() > 0))
+    {
+      if (this->_manifest.length() >= IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE)
+      {
+        this->fail(F("Manifest is too large."));
+        return;
+      }
+      this->_manifest += (char)this->_client.read();
+      this->_lastDataMs = millis();
+    }
+    bool complete = (this->_contentLength >= 0) ?
+      ((int)this->_manifest.length() >= this->_contentLength) :
+      (!this->_client.connected() && (this->_client.available() == 0));
+    if (complete)
+    {
+      this->_client.stop();
+      this->_state = StateIdle;
+      this->processManifest();
+      return;
+    }
+    this->checkConnection(F("Manifest download interrupted."));
+  }
+
+  void processManifest()
+  {
+    String version = getManifestValue(this->_manifest, "version");
+    size_t size = getManifestValue(this->_manifest, "size").toInt();
+    String firmwareUrl = getManifestValue(this->_manifest, "url");
+    this->_expectedDigest = getManifestValue(this->_manifest, "sha256");
+    this->_expectedDigest.toLowerCase();
+    this->_manifest = String();
+    if ((version.length() == 0) || (size == 0) ||
+      (firmwareUrl.length() == 0) || (this->_expectedDigest.length() != 64))
+    {
+      this->fail(F("Invalid manifest."));
+      return;
+    }
+    if (compareVersions(version.c_str(), this->_currentVersion) <= 0)
+    {
+      IOTWEBCONF_DEBUG_LINE(F("Firmware is up to date."));
+      this->_lastError = String();
+      return;
+    }
+    if ((this->_updateStartingCallback != nullptr) &&
+      !this->_updateStartingCallback(version.c_str()))
+    {
+      return;
+    }
+
+#ifdef IOTWEBCONF_DEBUG_TO_SERIAL
+    Serial.print(F("Updating firmware to version "));
+    Serial.println(version);
+#endif
+    if (!this->sendRequest(firmwareUrl))
+    {
+      this->fail(F("Firmware server not available."));
+      return;
+    }
+    this->_size = size;
+    this->_state = StateImageHeaders;
+  }
+
+  void downloadStep()
+  {
+    size_t available = this->_client.available();
+    if (available == 0)
+    {
+      if (!this->_client.connected() ||
+        (millis() - this->_lastDataMs > IOTWEBCONF_UPDATE_CLIENT_TIMEOUT_MS))
+      {
+        this->abortDownload(F("Firmware download interrupted."));
+      }
+      return;
+    }
+
+    uint8_t buffer[IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE];
+    size_t length = available < sizeof(buffer) ? available : sizeof(buffer);
+    if (length > this->_size - this->_received)
+    {
+      length = this->_size - this->_received;
+    }
+    int readLength = this->_client.read(buffer, length);
+    if (readLength <= 0)
+    {
+      return;
+    }
+    length = readLength;
+    this->shaUpdate(buffer, length);
+    this->_lastDataMs = millis();
+    if (this->_received + length == this->_size)
+    {
+      // -- Last piece is only written, when the digest matches, so a
+      // rejected image is never complete (and never activated).
+      if (!this->shaFinishAndCheck())
+      {
+        this->abortDownload(F("SHA-256 digest mismatch."));
+        return;
+      }
+    }
+    if (Update.write(buffer, length) != length)
+    {
+      this->abortDownload(F("Firmware write failed."));
+      return;
+    }
+    this->_received += length;
+
+    if (this->_received == this->_size)
+    {
+      this->finishDownload();
+    }
+  }
+
+  void finishDownload()
+  {
+    this->_client.stop();
+    this->shaEnd();
+    this->_state = StateIdle;
+    if (!Update.end())
+    {
+      this->fail(F("Firmware could not be activated."));
+      return;
+    }
+    IOTWEBCONF_DEBUG_LINE(F("Firmware updated. Rebooting..."));
+    delay(100);
+    ESP.restart();
+  }
+
+  void abortDownload(const __FlashStringHelper* error)
+  {
+    this->shaEnd();
+    // -- Image is incomplete, so it is discarded.
+    Update.end();
+    this->fail(error);
+  }
+
+  /**
+   * Gives up the current request, if the connection was closed or no data
+   * arrived for a while.
+   */
+  void checkConnection(const __FlashStringHelper* error)
+  {
+    if ((this->_state != StateIdle) &&
+      ((!this->_client.connected() && (this->_client.available() == 0)) ||
+        (millis() - this->_lastDataMs > IOTWEBCONF_UPDATE_CLIENT_TIMEOUT_MS)))
+    {
+      this->fail(error);
+    }
+  }
+
+  void fail(const String& error)
+  {
+    this->_client.stop();
+    this->_state = StateIdle;
+    this->_lastError = error;
+    IOTWEBCONF_DEBUG_LINE(this->_lastError);
+  }
+
+  static String getManifestValue(const String& manifest, const char* key)
+  {
+    String prefix = String(key) + '=';
+    int start = 0;
+    while (start < (int)manifest.length())
+    {
+      int end = manifest.indexOf('\n', start);
+      if (end < 0)
+      {
+        end = manifest.length();
+      }
+      String line = manifest.substring(start, end);
+      line.trim();
+      if (line.startsWith(prefix))
+      {
+        return line.substring(prefix.length());
+      }
+      start = end + 1;
+    }
+    return String();
+  }
+
+private:
+  void shaBegin()
+  {
+#ifdef ESP8266
+    br_sha256_init(&this->_sha256);
+#elif defined(ESP32)
+    mbedtls_sha256_init(&this->_sha256);
+    IOTWEBCONF_SHA256_STARTS(&this->_sha256, 0);
+#endif
+  }
+  void shaUpdate(const uint8_t* data, size_t length)
+  {
+#ifdef ESP8266
+    br_sha256_update(&this->_sha256, data, length);
+#elif defined(ESP32)
+    IOTWEBCONF_SHA256_UPDATE(&this->_sha256, data, length);
+#endif
+  }
+  void shaEnd()
+  {
+#ifdef ESP32
+    mbedtls_sha256_free(&this->_sha256);
+#endif
+  }
+  bool shaFinishAndCheck()
+  {
+    unsigned char digest[32];
+#ifdef ESP8266
+    br_sha256_out(&this->_sha256, digest);
+#elif defined(ESP32)
+    IOTWEBCONF_SHA256_FINISH(&this->_sha256, digest);
+#endif
+    char hex[65];
+    for (int i = 0; i < 32; i++)
+    {
+      snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    }
+    return this->_expectedDigest.equals(hex);
+  }
+
+  const char* _currentVersion;
+  const char* _manifestUrl = nullptr;
+  unsigned long _checkIntervalMs = IOTWEBCONF_UPDATE_CLIENT_CHECK_INTERVAL_MS;
+  std::function<bool(const char* newVersion)> _updateStartingCallback = nullptr;
+  bool _checkRequested = true;
+  unsigned long _lastCheckMs = 0;
+  State _state = StateIdle;
+  String _lastError;
+
+  WiFiClient _client;
+  int _statusCode = 0;
+  long _contentLength = -1;
+  String _line;
+  String _manifest;
+  String _expectedDigest;
+  size_t _size = 0;
+  size_t _received = 0;
+  unsigned long _lastDataMs = 0;
+#ifdef ESP8266
+  br_sha256_context _sha256;
+#elif defined(ESP32)
+  mbedtls_sha256_context _sha256;
+#endif
+};
+
+} // end namespace
+
+#endif
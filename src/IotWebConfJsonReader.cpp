@@ -0,0 +1,317 @@
+/**
+ * IotWebConfJsonReader.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "IotWebConfJsonReader.h"
+
+namespace iotwebconf
+{
+
+bool JsonStreamReader::read(JsonStreamHandler* handler)
+{
+  this->_handler = handler;
+  this->_peeked = -1;
+  if (this->skipWhitespace() != '{')
+  {
+    return false;
+  }
+  return this->readObject(nullptr, 1) && (this->skipWhitespace() < 0);
+}
+
+int JsonStreamReader::peek()
+{
+  if (this->_peeked < 0)
+  {
+    char c;
+    if (this->_in->readBytes(&c, 1) == 1)
+    {
+      this->_peeked = (unsigned char)c;
+    }
+  }
+  return this->_peeked;
+}
+
+int JsonStreamReader::next()
+{
+  int c = this->peek();
+  this->_peeked = -1;
+  return c;
+}
+
+int JsonStreamReader::skipWhitespace()
+{
+  int c = this->peek();
+  while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+  {
+    this->next();
+    c = this->peek();
+  }
+  return c;
+}
+
+bool JsonStreamReader::readValue(const char* key, byte depth)
+{
+  int c = this->skipWhitespace();
+  if (c == '{')
+  {
+    return this->readObject(key, depth + 1);
+  }
+  if (c == '[')
+  {
+    return this->readArray(depth + 1);
+  }
+
+  String value;
+  if (c == '"')
+  {
+    this->next();
+    if (!this->readString(&value))
+    {
+      return false;
+    }
+  }
+  else
+  {
+    if (!this->readLiteral(&value))
+    {
+      return false;
+    }
+    if (value.equals("null"))
+    {
+      return true;
+    }
+  }
+  this->_handler->value(key, value);
+  return true;
+}
+
+bool JsonStreamReader::readObject(const char* key, byte depth)
+{
+  if (depth > IOTWEBCONF_JSON_MAX_DEPTH)
+  {
+    return false;
+  }
+  this->next(); // -- '{'
+  this->_handler->beginObject(key);
+
+  char childKey[IOTWEBCONF_JSON_MAX_KEY_LEN + 1];
+  if (this->skipWhitespace() == '}')
+  {
+    this->next();
+    this->_handler->endObject();
+    return true;
+  }
+  while (true)
+  {
+    if (this->skipWhitespace() != '"')
+    {
+      return false;
+    }
+    this->next();
+    if (!this->readKey(childKey))
+    {
+      return false;
+    }
+    if (this->skipWhitespace() != ':')
+    {
+      return false;
+    }
+    this->next();
+    if (!this->readValue(childKey, depth))
+    {
+      return false;
+    }
+    this->skipWhitespace();
+    int c = this->next();
+    if (c == '}')
+    {
+      break;
+    }
+    if (c != ',')
+    {
+      return false;
+    }
+  }
+  this->_handler->endObject();
+  return true;
+}
+
+bool JsonStreamReader::readArray(byte depth)
+{
+  if (depth > IOTWEBCONF_JSON_MAX_DEPTH)
+  {
+    return false;
+  }
+  this->next(); // -- '['
+  if (this->skipWhitespace() == ']')
+  {
+    this->next();
+    return true;
+  }
+  while (true)
+  {
+    if (!this->readValue(nullptr, depth))
+    {
+      return false;
+    }
+    this->skipWhitespace();
+    int c = this->next();
+    if (c == ']')
+    {
+      return true;
+    }
+    if (c != ',')
+    {
+      return false;
+    }
+  }
+}
+
+bool JsonStreamReader::readKey(char* key)
+{
+  String value;
+  if (!this->readString(&value))
+  {
+    return false;
+  }
+  if (value.length() > IOTWEBCONF_JSON_MAX_KEY_LEN)
+  {
+    // -- Would not match any item anyway.
+    key[0] = '\0';
+  }
+  else
+  {
+    strcpy(key, value.c_str());
+  }
+  return true;
+}
+
+bool JsonStreamReader::readString(String* value)
+{
+  // -- Opening quote is already consumed.
+  while (true)
+  {
+    int c = this->next();
+    if ((c < 0x20) || (c == '"'))
+    {
+      // -- End of stream (-1) and control characters are invalid.
+      return c == '"';
+    }
+    if (c != '\\')
+    {
+      if (!this->appendChar(value, c))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    c = this->next();
+    bool appended;
+    switch (c)
+    {
+      case '"':
+      case '\\':
+      case '/':
+        appended = this->appendChar(value, c);
+        break;
+      case 'b':
+        appended = this->appendChar(value, '\b');
+        break;
+      case 'f':
+        appended = this->appendChar(value, '\f');
+        break;
+      case 'n':
+        appended = this->appendChar(value, '\n');
+        break;
+      case 'r':
+        appended = this->appendChar(value, '\r');
+        break;
+      case 't':
+        appended = this->appendChar(value, '\t');
+        break;
+      case 'u':
+      {
+        unsigned int code = 0;
+        for (byte i = 0; i < 4; i++)
+        {
+          c = this->next();
+          if (!isxdigit(c))
+          {
+            return false;
+          }
+          code = (code << 4) | (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+        }
+        // -- Encode as UTF-8. (Surrogate pairs are not combined.)
+        if (code < 0x80)
+        {
+          appended = this->appendChar(value, code);
+        }
+        else if (code < 0x800)
+        {
+          appended =
+            this->appendChar(value, 0xC0 | (code >> 6)) &&
+            this->appendChar(value, 0x80 | (code & 0x3F));
+        }
+        else
+        {
+          appended =
+            this->appendChar(value, 0xE0 | (code >> 12)) &&
+            this->appendChar(value, 0x80 | ((code >> 6) & 0x3F)) &&
+            this->appendChar(value, 0x80 | (code & 0x3F));
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+    if (!appended)
+    {
+      // -- Value is too long; rather fail, than apply it truncated.
+      return false;
+    }
+  }
+}
+
+bool JsonStreamReader::readLiteral(String* value)
+{
+  int c = this->peek();
+  while (isalnum(c) || (c == '-') || (c == '+') || (c == '.'))
+  {
+    if (!this->appendChar(value, this->next()))
+    {
+      return false;
+    }
+    c = this->peek();
+  }
+  if (value->equals("true") || value->equals("false") || value->equals("null"))
+  {
+    return true;
+  }
+  if (value->length() == 0)
+  {
+    return false;
+  }
+  char* end;
+  strtod(value->c_str(), &end);
+  return *end == '\0';
+}
+
+bool JsonStreamReader::appendChar(String* value, char c)
+{
+  if (value->length() >= IOTWEBCONF_JSON_MAX_VALUE_LEN)
+  {
+    return false;
+  }
+  *value += c;
+  return true;
+}
+
+} // end namespace
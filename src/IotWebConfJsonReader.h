@@ -0,0 +1,76 @@
+/**
+ * IotWebConfJsonReader.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfJsonReader_h
+#define IotWebConfJsonReader_h
+
+#include <Arduino.h>
+#include "IotWebConfSettings.h"
+
+namespace iotwebconf
+{
+
+/**
+ * Receives the elements of a JSON document from a JsonStreamReader, in the
+ * order of the document. Key is nullptr for array elements and the root.
+ */
+class JsonStreamHandler
+{
+public:
+  virtual void beginObject(const char* key) { }
+  virtual void endObject() { }
+  /**
+   * Called with every string, number and boolean value. Numbers and
+   * booleans are provided as they appear in the document, null values
+   * are not reported.
+   */
+  virtual void value(const char* key, const String& value) = 0;
+};
+
+/**
+ * Reads a JSON document from a stream character by character, and reports
+ * its elements to a handler (SAX style). The document is never kept in
+ * memory, only the current key and value, so the memory usage does not
+ * depend on the size of the document.
+ * Keys longer than IOTWEBCONF_JSON_MAX_KEY_LEN are reported as empty keys,
+ * a value longer than IOTWEBCONF_JSON_MAX_VALUE_LEN makes the read fail.
+ */
+class JsonStreamReader
+{
+public:
+  JsonStreamReader(Stream* in) : _in(in) { }
+
+  /**
+   * Returns false, if the document is not a valid JSON object. Note, that
+   * elements before the error were already reported.
+   */
+  bool read(JsonStreamHandler* handler);
+
+private:
+  int peek();
+  int next();
+  int skipWhitespace();
+  bool readValue(const char* key, byte depth);
+  bool readObject(const char* key, byte depth);
+  bool readArray(byte depth);
+  bool readString(String* value);
+  bool readKey(char* key);
+  bool readLiteral(String* value);
+  bool appendChar(String* value, char c);
+
+  Stream* _in;
+  JsonStreamHandler* _handler = nullptr;
+  int _peeked = -1;
+};
+
+} // end namespace
+
+#endif
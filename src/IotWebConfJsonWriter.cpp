@@ -0,0 +1,97 @@
+/**
+ * IotWebConfJsonWriter.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "IotWebConfJsonWriter.h"
+
+namespace iotwebconf
+{
+
+void JsonWriter::beginObject(const char* key)
+{
+  if (key != nullptr)
+  {
+    this->writeKey(key);
+  }
+  this->_out->print('{');
+  this->_needComma = false;
+}
+
+void JsonWriter::endObject()
+{
+  this->_out->print('}');
+  this->_needComma = true;
+}
+
+void JsonWriter::value(const char* key, const char* value)
+{
+  this->writeKey(key);
+  this->writeString(value);
+  this->_needComma = true;
+}
+
+void JsonWriter::passwordValue(const char* key, const char* value)
+{
+  if (this->_passwordPolicy == JsonPasswordOmit)
+  {
+    return;
+  }
+  this->value(key, this->_passwordPolicy == JsonPasswordPlain ? value : "");
+}
+
+void JsonWriter::writeKey(const char* key)
+{
+  if (this->_needComma)
+  {
+    this->_out->print(',');
+  }
+  this->writeString(key);
+  this->_out->print(':');
+}
+
+void JsonWriter::writeString(const char* text)
+{
+  this->_out->print('"');
+  for (const char* c = text; *c != '\0'; c++)
+  {
+    switch (*c)
+    {
+      case '"':
+        this->_out->print(F("\\\""));
+        break;
+      case '\\':
+        this->_out->print(F("\\\\"));
+        break;
+      case '\n':
+        this->_out->print(F("\\n"));
+        break;
+      case '\r':
+        this->_out->print(F("\\r"));
+        break;
+      case '\t':
+        this->_out->print(F("\\t"));
+        break;
+      default:
+        if ((unsigned char)*c < 0x20)
+        {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)*c);
+          this->_out->print(escaped);
+        }
+        else
+        {
+          this->_out->print(*c);
+        }
+    }
+  }
+  this->_out->print('"');
+}
+
+} // end namespace
@@ -0,0 +1,67 @@
+/**
+ * IotWebConfJsonWriter.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfJsonWriter_h
+#define IotWebConfJsonWriter_h
+
+#include <Arduino.h>
+
+namespace iotwebconf
+{
+
+/**
+ * How password values are written in a JSON export.
+ *   - JsonPasswordOmit: Passwords are left out.
+ *   - JsonPasswordMask: Passwords are written as empty strings. When loaded
+ *     back, empty password means "not changed".
+ *   - JsonPasswordPlain: Passwords are written as they are.
+ */
+typedef enum JsonPasswordPolicy
+{
+  JsonPasswordOmit,
+  JsonPasswordMask,
+  JsonPasswordPlain
+} JsonPasswordPolicy;
+
+/**
+ * Writes a JSON document directly to the output, element by element, so no
+ * document is built in the memory. Takes care of the separators and
+ * escaping.
+ */
+class JsonWriter
+{
+public:
+  JsonWriter(Print* out, JsonPasswordPolicy passwordPolicy = JsonPasswordOmit) :
+    _out(out), _passwordPolicy(passwordPolicy) { }
+
+  /**
+   * Starts a nested object. Key should be nullptr for the root object.
+   */
+  void beginObject(const char* key);
+  void endObject();
+  void value(const char* key, const char* value);
+  /**
+   * Writes the value according to the password policy.
+   */
+  void passwordValue(const char* key, const char* value);
+
+private:
+  void writeKey(const char* key);
+  void writeString(const char* text);
+
+  Print* _out;
+  JsonPasswordPolicy _passwordPolicy;
+  bool _needComma = false;
+};
+
+} // end namespace
+
+#endif
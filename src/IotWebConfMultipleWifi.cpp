@@ -38,6 +38,7 @@ void MultipleWifiAddition::init()
   while(set != nullptr)
   {
     this->_iotWebConf->addSystemParameter(set);
+    this->_iotWebConf->addConstraint(&set->wifiPasswordConstraint);
     set = (ChainedWifiParameterGroup*)set->getNext();
   }
 
@@ -45,16 +46,40 @@ void MultipleWifiAddition::init()
   this->_iotWebConf->setHtmlFormatProvider(
     &this->_optionalGroupHtmlFormatProvider);
 
-  // -- Set up handler, that will selects next connection info to use.
-  this->_iotWebConf->setFormValidator([&](WebRequestWrapper* webRequestWrapper)
+
+  // -- Set up handler, that will rank the sets by the scan results.
+  if (this->_scanEnabled)
+  {
+    this->_iotWebConf->setWifiScanResultHandler([&](int networkCount)
+      {
+        return this->handleScanResult(networkCount);
+      });
+  }
+
+  // -- Accept any of our networks when roaming.
+  this->_iotWebConf->setRoamingCandidateHandler([&](const char* ssid)
     {
-      return this->formValidator(webRequestWrapper);
+      return this->findKnownNetwork(ssid);
     });
 
   // -- Set up handler, that will selects next connection info to use.
   this->_iotWebConf->setWifiConnectionFailedHandler([&]()
     {
         WifiAuthInfo* result;
+        if (this->_ranked)
+        {
+          result = this->nextRankedSet();
+          if (result == nullptr)
+          {
+            result = this->nextUnseenSet();
+          }
+          if (result == nullptr)
+          {
+            this->_ranked = false;
+            this->_iotWebConf->resetWifiAuthInfo();
+          }
+          return result;
+        }
         while (true)
         {
           if (this->_currentSet == nullptr)
@@ -84,6 +109,133 @@ void MultipleWifiAddition::init()
     });
 };
 
+WifiAuthInfo* MultipleWifiAddition::handleScanResult(int networkCount)
+{
+  WifiParameterGroup* primary = this->_iotWebConf->getWifiParameterGroup();
+  this->_primaryWifiAuthInfo = { primary->_wifiSsid, primary->_wifiPassword };
+  this->_primaryScanRssi = IOTWEBCONF_RSSI_NONE;
+  this->_primaryScanSeen = false;
+  ChainedWifiParameterGroup* set = this->_firstSet;
+  while(set != nullptr)
+  {
+    set->_scanRssi = IOTWEBCONF_RSSI_NONE;
+    set->_scanSeen = false;
+    set = (ChainedWifiParameterGroup*)set->getNext();
+  }
+
+  // -- Keep the best signal for each known SSID.
+  for (int i = 0; i < networkCount; i++)
+  {
+    String ssid = WiFi.SSID(i);
+    int32_t rssi = WiFi.RSSI(i);
+    if (ssid.equals(primary->_wifiSsid) && (rssi > this->_primaryScanRssi))
+    {
+      this->_primaryScanRssi = rssi;
+      this->_primaryScanSeen = true;
+    }
+    set = this->_firstSet;
+    while(set != nullptr)
+    {
+      if (set->isActive() && (set->wifiSsid[0] != '\0') &&
+        ssid.equals(set->wifiSsid) && (rssi > set->_scanRssi))
+      {
+        set->_scanRssi = rssi;
+        set->_scanSeen = true;
+      }
+      set = (ChainedWifiParameterGroup*)set->getNext();
+    }
+  }
+
+  this->_ranked = true;
+  this->_currentSet = this->_firstSet;
+  WifiAuthInfo* result = this->nextRankedSet();
+  if (result == nullptr)
+  {
+    result = this->nextUnseenSet();
+  }
+  if (result == nullptr)
+  {
+    this->_ranked = false;
+    this->_iotWebConf->resetWifiAuthInfo();
+  }
+  return result;
+}
+
+WifiAuthInfo* MultipleWifiAddition::nextRankedSet()
+{
+  // -- Primary WiFi wins on equal signal strength.
+  int32_t bestRssi = this->_primaryScanRssi;
+  ChainedWifiParameterGroup* best = nullptr;
+  ChainedWifiParameterGroup* set = this->_firstSet;
+  while(set != nullptr)
+  {
+    if (set->_scanRssi > bestRssi)
+    {
+      bestRssi = set->_scanRssi;
+      best = set;
+    }
+    set = (ChainedWifiParameterGroup*)set->getNext();
+  }
+
+  if (best != nullptr)
+  {
+    best->_scanRssi = IOTWEBCONF_RSSI_NONE; // -- Do not try it again in this round.
+    return &best->wifiAuthInfo;
+  }
+  if (this->_primaryScanRssi != IOTWEBCONF_RSSI_NONE)
+  {
+    this->_primaryScanRssi = IOTWEBCONF_RSSI_NONE;
+    return &this->_primaryWifiAuthInfo;
+  }
+  return nullptr;
+}
+
+WifiAuthInfo* MultipleWifiAddition::nextUnseenSet()
+{
+  // -- Hidden networks are never seen by the scan, these are tried after the
+  // networks in range, in the original order.
+  if (!this->_probeHidden)
+  {
+    return nullptr;
+  }
+  if (!this->_primaryScanSeen)
+  {
+    this->_primaryScanSeen = true; // -- Do not try it again in this round.
+    return &this->_primaryWifiAuthInfo;
+  }
+  while (this->_currentSet != nullptr)
+  {
+    ChainedWifiParameterGroup* set = this->_currentSet;
+    this->_currentSet = (ChainedWifiParameterGroup*)set->getNext();
+    if (set->isActive() && !set->_scanSeen && (set->wifiSsid[0] != '\0'))
+    {
+      return &set->wifiAuthInfo;
+    }
+  }
+  return nullptr;
+}
+
+WifiAuthInfo* MultipleWifiAddition::findKnownNetwork(const char* ssid)
+{
+  WifiParameterGroup* primary = this->_iotWebConf->getWifiParameterGroup();
+  if (strcmp(primary->_wifiSsid, ssid) == 0)
+  {
+    this->_primaryWifiAuthInfo = { primary->_wifiSsid, primary->_wifiPassword };
+    return &this->_primaryWifiAuthInfo;
+  }
+  ChainedWifiParameterGroup* set = this->_firstSet;
+  while(set != nullptr)
+  {
+    if (set->isActive() && (set->wifiSsid[0] != '\0') &&
+      (strcmp(set->wifiSsid, ssid) == 0))
+    {
+      return &set->wifiAuthInfo;
+    }
+    set = (ChainedWifiParameterGroup*)set->getNext();
+  }
+  return nullptr;
+}
+
 bool MultipleWifiAddition::formValidator(
   WebRequestWrapper* webRequestWrapper)
 {
@@ -15,6 +15,9 @@
 #include "IotWebConfOptionalGroup.h"
 #include "IotWebConf.h" // for WebRequestWrapper
 
+// -- Marks a network not found (or already tried) in the last WiFi scan.
+#define IOTWEBCONF_RSSI_NONE INT32_MIN
+
 namespace iotwebconf
 {
 
@@ -37,11 +40,25 @@ public:
   char wifiSsid[IOTWEBCONF_WORD_LEN];
   char wifiPassword[IOTWEBCONF_PASSWORD_LEN];
   WifiAuthInfo wifiAuthInfo = { wifiSsid,  wifiPassword};
+  // -- Password length is only checked for active sets.
+  RuleConstraint wifiPasswordConstraint =
+    RuleConstraint(&this->wifiPasswordParameter,
+      "Password length must be at least 8 characters.",
+      [this](FormSnapshot* form)
+      {
+        unsigned int l = form->get(this->wifiPasswordParameter.getId()).length();
+        return !this->isActive() || (l == 0) || (8 <= l);
+      });
 protected:
 
 private:
   char _wifiSsidParameterId[IOTWEBCONF_WORD_LEN];
   char _wifiPasswordParameterId[IOTWEBCONF_WORD_LEN];
+  // -- Signal strength found by the last scan, or IOTWEBCONF_RSSI_NONE.
+  int32_t _scanRssi = IOTWEBCONF_RSSI_NONE;
+  // -- Whether the last scan found this network.
+  bool _scanSeen = false;
+  friend class MultipleWifiAddition;
 };
 
 class MultipleWifiAddition
@@ -52,19 +69,68 @@ public:
     ChainedWifiParameterGroup sets[],
     size_t setsSize);
   /**
-   * Note, that init() calls setFormValidator, that overwrites existing
-   * formValidator setup. Thus your setFormValidator should be called
-   * _after_ multipleWifiAddition.init() .
+   * Adds the sets to the system parameters, and registers the password
+   * constraints of the sets. (The form validator is not touched.)
    */
   virtual void init();
 
+  /**
+   * Checks the passwords of the active sets. Not called by IotWebConf any more,
+   * as the same check is done by the constraints registered in init().
+   */
   virtual bool formValidator(
     WebRequestWrapper* webRequestWrapper);
 
+  /**
+   * By default a WiFi scan is performed at the beginning of every
+   * connection round, and networks in range are tried in descending signal
+   * strength order. Networks not seen by the scan are skipped, and when
+   * none of the networks is in range, AP mode is started right away.
+   * Disabling the scan falls back to trying all active sets one after
+   * another.
+   * Must be called before init()!
+   */
+  void setNetworkScanEnabled(bool enabled) { this->_scanEnabled = enabled; }
+
+  /**
+   * Hidden networks are never seen by the scan. With probing enabled,
+   * networks not seen by the scan are still tried after the ones in range
+   * (in the original order), each costing a full connection timeout.
+   * Disabled by default.
+   */
+  void setHiddenNetworkProbingEnabled(bool enabled) { this->_probeHidden = enabled; }
+
 protected:
+  /**
+   * Matches scan results against the active sets, and returns the
+   * strongest one. Returns nullptr if no active set is in range.
+   */
+  virtual WifiAuthInfo* handleScanResult(int networkCount);
+  /**
+   * Returns the strongest not yet tried set of the last scan.
+   */
+  virtual WifiAuthInfo* nextRankedSet();
+  /**
+   * Returns the next not yet tried network, that was not seen by the last
+   * scan (e.g. a hidden network). Returns nullptr, if hidden network
+   * probing is not enabled.
+   */
+  virtual WifiAuthInfo* nextUnseenSet();
+  /**
+   * Returns the connection info of the primary WiFi or the active set
+   * with the SSID provided. Returns nullptr, if the network is unknown.
+   */
+  virtual WifiAuthInfo* findKnownNetwork(const char* ssid);
+
   IotWebConf* _iotWebConf;
   ChainedWifiParameterGroup* _firstSet;
   ChainedWifiParameterGroup* _currentSet;
+  bool _scanEnabled = true;
+  bool _probeHidden = false;
+  bool _ranked = false;
+  int32_t _primaryScanRssi = IOTWEBCONF_RSSI_NONE;
+  bool _primaryScanSeen = false;
+  WifiAuthInfo _primaryWifiAuthInfo;
 
   iotwebconf::OptionalGroupHtmlFormatProvider _optionalGroupHtmlFormatProvider;
 };
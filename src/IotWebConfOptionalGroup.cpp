@@ -23,7 +23,8 @@ OptionalParameterGroup::OptionalParameterGroup(const char* id, const char* label
 
 int OptionalParameterGroup::getStorageSize()
 {
-  return ParameterGroup::getStorageSize() + 1;
+  // -- When packed, the active flag is stored by the parent group.
+  return ParameterGroup::getStorageSize() + (this->isFlagPacked() ? 0 : 1);
 }
 
 void OptionalParameterGroup::applyDefaultValue()
@@ -32,33 +33,87 @@ void OptionalParameterGroup::applyDefaultValue()
   ParameterGroup::applyDefaultValue();
 }
 
-void OptionalParameterGroup::storeValue(
-  std::function<void(SerializationData* serializationData)> doStore)
+void OptionalParameterGroup::storeValueTo(Serializer& serializer)
 {
   // -- Store active flag.
-  byte data[1];
-  data[0] = (byte)this->_active;
-  SerializationData serializationData;
-  serializationData.length = 1;
-  serializationData.data = data;
-  doStore(&serializationData);
+  if (!this->isFlagPacked())
+  {
+    byte data[1];
+    data[0] = (byte)this->_active;
+    SerializationData serializationData;
+    serializationData.length = 1;
+    serializationData.data = data;
+    serializer.serialize(&serializationData);
+  }
 
   // -- Store other items.
-  ParameterGroup::storeValue(doStore);
+  ParameterGroup::storeValueTo(serializer);
 }
-void OptionalParameterGroup::loadValue(
-  std::function<void(SerializationData* serializationData)> doLoad)
+void OptionalParameterGroup::loadValueFrom(Serializer& serializer)
 {
   // -- Load activity.
-  byte data[1];
-  SerializationData serializationData;
-  serializationData.length = 1;
-  serializationData.data = data;
-  doLoad(&serializationData);
-  this->_active = (bool)data[0];
-  
+  if (!this->isFlagPacked())
+  {
+    byte data[1];
+    SerializationData serializationData;
+    serializationData.length = 1;
+    serializationData.data = data;
+    serializer.serialize(&serializationData);
+    this->_active = (bool)data[0];
+  }
+
   // -- Load other items.
-  ParameterGroup::loadValue(doLoad);
+  ParameterGroup::loadValueFrom(serializer);
+}
+
+bool OptionalParameterGroup::isActiveId(const char* id)
+{
+  size_t length = strlen(this->getId());
+  return (strncmp(id, this->getId(), length) == 0) &&
+    (id[length] == 'v') && (id[length + 1] == '\0');
+}
+
+#ifdef IOTWEBCONF_ENABLE_JSON
+void OptionalParameterGroup::loadFromJson(JsonObject jsonObject)
+{
+  if (jsonObject.containsKey(this->getId()))
+  {
+    JsonObject myObject = jsonObject[this->getId()];
+    String activeId = String(this->getId());
+    activeId += 'v';
+    if (myObject.containsKey(activeId.c_str()))
+    {
+      const char* activeStr = myObject[activeId.c_str()];
+      this->_active = (activeStr != nullptr) && (strcmp(activeStr, "active") == 0);
+    }
+  }
+  ParameterGroup::loadFromJson(jsonObject);
+}
+#endif
+
+bool OptionalParameterGroup::loadJsonValue(const char* id, const String& value)
+{
+  if (this->isActiveId(id))
+  {
+    this->_active = value.equals("active");
+    return true;
+  }
+  return ParameterGroup::loadJsonValue(id, value);
+}
+
+void OptionalParameterGroup::writeJson(JsonWriter* writer)
+{
+  writer->beginObject(this->getId());
+  String activeId = String(this->getId());
+  activeId += 'v';
+  writer->value(activeId.c_str(), this->_active ? "active" : "inactive");
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    current->writeJson(writer);
+    current = this->getNextItemOf(current);
+  }
+  writer->endObject();
 }
 
 void OptionalParameterGroup::renderHtml(
@@ -154,5 +209,270 @@ String ChainedParameterGroup::getEndTemplate()
   return result;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+
+RepeatedParameterGroup::RepeatedParameterGroup(
+  const char* id, const char* label, ParameterGroup* elements[], byte maxCount)
+  : ParameterGroup(id, label)
+{
+  this->_elements = elements;
+  this->_maxCount = maxCount;
+  if (maxCount > IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS)
+  {
+    // -- Elements above the limit could not be marked live, so these are
+    // not part of the group at all.
+    IOTWEBCONF_DEBUG_LINE(
+      F("Too many elements in repeated group, extra elements are ignored."));
+    this->_maxCount = IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS;
+  }
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    this->addItem(elements[i]);
+  }
+}
+
+byte RepeatedParameterGroup::getCount()
+{
+  byte count = 0;
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    if (this->isLive(i))
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+int RepeatedParameterGroup::add()
+{
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    if (!this->isLive(i))
+    {
+      this->_liveMask |= ((uint32_t)1 << i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+void RepeatedParameterGroup::remove(byte index)
+{
+  this->_liveMask &= ~((uint32_t)1 << index);
+  this->_elements[index]->applyDefaultValue();
+}
+
+void RepeatedParameterGroup::applyDefaultValue()
+{
+  this->_liveMask = 0;
+  ParameterGroup::applyDefaultValue();
+}
+
+int RepeatedParameterGroup::getStorageSize()
+{
+  return ParameterGroup::getStorageSize() + this->getMaskSize();
+}
+
+void RepeatedParameterGroup::storeValueTo(Serializer& serializer)
+{
+  // -- Store live mask, lowest bits first.
+  byte data[IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS / 8];
+  for (size_t i = 0; i < sizeof(data); i++)
+  {
+    data[i] = (byte)(this->_liveMask >> (8 * i));
+  }
+  SerializationData serializationData;
+  serializationData.length = this->getMaskSize();
+  serializationData.data = data;
+  serializer.serialize(&serializationData);
+
+  // -- Store only the live elements, the mask tells which slots these are.
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    ConfigItem* element = this->_elements[i];
+    if (this->isLive(i))
+    {
+      element->storeValueTo(serializer);
+    }
+  }
+}
+void RepeatedParameterGroup::loadValueFrom(Serializer& serializer)
+{
+  // -- Load live mask.
+  byte data[IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS / 8] = { 0 };
+  SerializationData serializationData;
+  serializationData.length = this->getMaskSize();
+  serializationData.data = data;
+  serializer.serialize(&serializationData);
+  this->_liveMask = 0;
+  for (int i = 0; i < serializationData.length; i++)
+  {
+    this->_liveMask |= (uint32_t)data[i] << (8 * i);
+  }
+  // -- Drop bits above the maximal count.
+  if (this->_maxCount < IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS)
+  {
+    this->_liveMask &= ((uint32_t)1 << this->_maxCount) - 1;
+  }
+
+  // -- Load live elements, free slots get the default values.
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    ConfigItem* element = this->_elements[i];
+    if (this->isLive(i))
+    {
+      element->loadValueFrom(serializer);
+    }
+    else
+    {
+      element->applyDefaultValue();
+    }
+  }
+}
+
+void RepeatedParameterGroup::renderElement(
+  byte index, bool shown, bool dataArrived, WebRequestWrapper* webRequestWrapper)
+{
+  ConfigItem* element = this->_elements[index];
+  const char* label = this->label != nullptr ? this->label : this->getId();
+  String content = getStartTemplate();
+  content.replace("{b}", label);
+  content.replace("{i}", element->getId());
+  content.replace("{v}", shown ? "active" : "inactive");
+  content.replace("{cb}", shown ? "hide" : "");
+  content.replace("{cf}", shown ? "" : "hide");
+  webRequestWrapper->sendContent(content);
+
+  element->renderHtml(dataArrived, webRequestWrapper);
+
+  content = getEndTemplate();
+  content.replace("{b}", label);
+  content.replace("{i}", element->getId());
+  webRequestWrapper->sendContent(content);
+}
+
+void RepeatedParameterGroup::renderHtml(
+  bool dataArrived, WebRequestWrapper* webRequestWrapper)
+{
+  // -- Render live elements, and only the first free slot.
+  bool freeRendered = false;
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    bool shown = this->isLive(i);
+    String activeId = String(this->_elements[i]->getId());
+    activeId += 'v';
+    if (dataArrived && webRequestWrapper->hasArg(activeId))
+    {
+      // -- Keep the state of the posted form.
+      shown = webRequestWrapper->arg(activeId).equals("active");
+    }
+    if (shown)
+    {
+      this->renderElement(i, true, dataArrived, webRequestWrapper);
+    }
+    else if (!freeRendered)
+    {
+      this->renderElement(i, false, dataArrived, webRequestWrapper);
+      freeRendered = true;
+    }
+  }
+}
+
+void RepeatedParameterGroup::update(WebRequestWrapper* webRequestWrapper)
+{
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    ConfigItem* element = this->_elements[i];
+    String activeId = String(element->getId());
+    activeId += 'v';
+    if (!webRequestWrapper->hasArg(activeId))
+    {
+      // -- Slot was not rendered.
+      continue;
+    }
+    if (webRequestWrapper->arg(activeId).equals("active"))
+    {
+      this->_liveMask |= ((uint32_t)1 << i);
+      element->update(webRequestWrapper);
+    }
+    else if (this->isLive(i))
+    {
+      this->remove(i);
+    }
+  }
+}
+
+#ifdef IOTWEBCONF_ENABLE_JSON
+void RepeatedParameterGroup::loadFromJson(JsonObject jsonObject)
+{
+  if (jsonObject.containsKey(this->getId()))
+  {
+    // -- Elements present in the JSON become live.
+    JsonObject myObject = jsonObject[this->getId()];
+    for (byte i = 0; i < this->_maxCount; i++)
+    {
+      if (myObject.containsKey(this->_elements[i]->getId()))
+      {
+        this->_liveMask |= ((uint32_t)1 << i);
+      }
+    }
+  }
+  ParameterGroup::loadFromJson(jsonObject);
+}
+#endif
+
+bool RepeatedParameterGroup::loadJsonValue(const char* id, const String& value)
+{
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    if (this->_elements[i]->loadJsonValue(id, value))
+    {
+      // -- Value arrived for the element, so it becomes live.
+      this->_liveMask |= ((uint32_t)1 << i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void RepeatedParameterGroup::valueApplied(ConfigItem* child)
+{
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    if (this->_elements[i] == child)
+    {
+      // -- Value arrived for the element, so it becomes live.
+      this->_liveMask |= ((uint32_t)1 << i);
+      return;
+    }
+  }
+}
+
+void RepeatedParameterGroup::writeJson(JsonWriter* writer)
+{
+  // -- Only the live elements.
+  writer->beginObject(this->getId());
+  for (byte i = 0; i < this->_maxCount; i++)
+  {
+    if (this->isLive(i))
+    {
+      this->_elements[i]->writeJson(writer);
+    }
+  }
+  writer->endObject();
+}
+
+void RepeatedParameterGroup::debugTo(Stream* out)
+{
+  out->print('[');
+  out->print(this->getCount());
+  out->print('/');
+  out->print(this->_maxCount);
+  out->print(']');
+
+  // Print rest.
+  ParameterGroup::debugTo(out);
+}
 
 }
\ No newline at end of file
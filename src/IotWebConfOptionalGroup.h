@@ -41,6 +41,9 @@ const char IOTWEBCONF_HTML_FORM_OPTIONAL_GROUP_END[] PROGMEM =
 const char IOTWEBCONF_HTML_FORM_CHAINED_GROUP_NEXTID[] PROGMEM =
   "<input type='hidden' id='{i}next' value='{in}'/>\n";
 
+// -- Maximal number of elements in a RepeatedParameterGroup.
+#define IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS 32
+
 namespace iotwebconf
 {
 
@@ -74,22 +77,36 @@ public:
   bool isActive() { return this->_active; }
   void setActive(bool active) { this->_active = active; }
 
+#ifdef IOTWEBCONF_ENABLE_JSON
+  void loadFromJson(JsonObject jsonObject) override;
+#endif
+  /**
+   * The active flag is read and written as "<id>v" (just like the form
+   *   field) with the value "active" or "inactive", inside the object of
+   *   the group.
+   */
+  bool loadJsonValue(const char* id, const String& value) override;
+  void writeJson(JsonWriter* writer) override;
+
 protected:
   int getStorageSize() override;
   void applyDefaultValue() override;
-  void storeValue(std::function<void(
-    SerializationData* serializationData)> doStore) override;
-  void loadValue(std::function<void(
-    SerializationData* serializationData)> doLoad) override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
   void renderHtml(bool dataArrived, WebRequestWrapper* webRequestWrapper) override;
   virtual String getStartTemplate() { return FPSTR(IOTWEBCONF_HTML_FORM_OPTIONAL_GROUP_START); };
   virtual String getEndTemplate() { return FPSTR(IOTWEBCONF_HTML_FORM_OPTIONAL_GROUP_END); };
   void update(WebRequestWrapper* webRequestWrapper) override;
   void debugTo(Stream* out) override;
+  bool isFlag() override { return true; }
+  bool getFlagValue() override { return this->_active; }
+  void setFlagValue(bool value) override { this->_active = value; }
 
 private:
   bool _defaultActive;
   bool _active;
+
+  bool isActiveId(const char* id);
 };
 
 class ChainedParameterGroup;
@@ -111,6 +128,87 @@ protected:
   ChainedParameterGroup* _nextGroup = nullptr;
 };
 
+/**
+ * RepeatedParameterGroup is a list of identical element groups with a
+ * maximal element count. Elements can be added and removed in the config
+ * portal, but only the live elements and a single free slot (with the add
+ * button) are rendered. The storage starts with a bitmask of the live slots,
+ * followed by the values of the live elements only. Room is reserved for all
+ * the slots (see getStorageSize()), but free slots are neither written nor
+ * read, these get their default values on load. Values loaded from JSON make
+ * their element live.
+ * At most IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS elements are supported.
+ * The array-based constructor checks this at compile time, the other one
+ * reports the error in the debug output, and ignores the extra elements.
+ * Element groups are expected to have no label, the label of the repeated
+ * group is displayed for each element.
+ * Just like with OptionalParameterGroup, OptionalGroupHtmlFormatProvider
+ * must be used.
+ *
+ * Example:
+ *   iotwebconf::ParameterGroup* elements[] = { &element1, &element2, &element3 };
+ *   iotwebconf::RepeatedParameterGroup
+ *     repeated("rep", "Sensor", elements);
+ */
+class RepeatedParameterGroup : public ParameterGroup
+{
+public:
+  RepeatedParameterGroup(
+    const char* id, const char* label, ParameterGroup* elements[], byte maxCount);
+  template <size_t count>
+  RepeatedParameterGroup(
+    const char* id, const char* label, ParameterGroup* (&elements)[count]) :
+    RepeatedParameterGroup(id, label, elements, (byte)count)
+  {
+    static_assert(count <= IOTWEBCONF_REPEATED_GROUP_MAX_ELEMENTS,
+      "Too many elements for a RepeatedParameterGroup.");
+  }
+
+  byte getMaxCount() { return this->_maxCount; }
+  /**
+   * Number of live elements.
+   */
+  byte getCount();
+  bool isLive(byte index) { return (this->_liveMask >> index) & 1; }
+  ParameterGroup* getElement(byte index) { return this->_elements[index]; }
+  /**
+   * Makes the first free slot live. Returns its index, or -1 if all
+   * slots are in use.
+   */
+  int add();
+  /**
+   * Removes the element, and resets its values to the defaults.
+   */
+  void remove(byte index);
+
+  void applyDefaultValue() override;
+#ifdef IOTWEBCONF_ENABLE_JSON
+  void loadFromJson(JsonObject jsonObject) override;
+#endif
+  bool loadJsonValue(const char* id, const String& value) override;
+  void writeJson(JsonWriter* writer) override;
+
+protected:
+  int getStorageSize() override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
+  void renderHtml(bool dataArrived, WebRequestWrapper* webRequestWrapper) override;
+  virtual String getStartTemplate() override { return FPSTR(IOTWEBCONF_HTML_FORM_OPTIONAL_GROUP_START); };
+  virtual String getEndTemplate() override { return FPSTR(IOTWEBCONF_HTML_FORM_OPTIONAL_GROUP_END); };
+  void update(WebRequestWrapper* webRequestWrapper) override;
+  void debugTo(Stream* out) override;
+  void valueApplied(ConfigItem* child) override;
+
+private:
+  ParameterGroup** _elements;
+  byte _maxCount;
+  uint32_t _liveMask = 0;
+
+  byte getMaskSize() { return (this->_maxCount + 7) / 8; }
+  void renderElement(
+    byte index, bool shown, bool dataArrived, WebRequestWrapper* webRequestWrapper);
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -11,6 +11,29 @@
 
 #include <IotWebConfParameter.h>
 
+namespace
+{
+
+/**
+ * Serializer calling a function provided to storeValue() or loadValue().
+ */
+class FunctionSerializer : public iotwebconf::Serializer
+{
+public:
+  FunctionSerializer(
+    std::function<void(iotwebconf::SerializationData* serializationData)>& function) :
+    _function(function) { }
+  void serialize(iotwebconf::SerializationData* serializationData) override
+  {
+    this->_function(serializationData);
+  }
+
+private:
+  std::function<void(iotwebconf::SerializationData* serializationData)>& _function;
+};
+
+} // end anonymous namespace
+
 namespace iotwebconf
 {
 
@@ -30,15 +53,156 @@ void ParameterGroup::addItem(ConfigItem* configItem)
   if (this->_firstItem == nullptr)
   {
     this->_firstItem = configItem;
-    return;
   }
+  else
+  {
+    this->_lastItem->_nextItem = configItem;
+  }
+  this->_lastItem = configItem;
+  configItem->_parentItem = this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ItemIndex::build(ConfigItem* root)
+{
+  this->_count = 0;
+  this->_built = root->addToIndex(this);
+  if (!this->_built)
+  {
+    this->_count = 0;
+    return false;
+  }
+
+  // -- Insertion sort, so items with the same id keep the order of the tree.
+  for (int i = 1; i < this->_count; i++)
+  {
+    Entry entry = this->_entries[i];
+    bool progmemId = entry.field >= 0;
+    const char* id = progmemId ?
+      entry.item->getFieldId(entry.field) : entry.item->getId();
+    int j = i;
+    while ((j > 0) && (this->compare(&this->_entries[j - 1], id, progmemId) > 0))
+    {
+      this->_entries[j] = this->_entries[j - 1];
+      j--;
+    }
+    this->_entries[j] = entry;
+  }
+  return true;
+}
+
+bool ItemIndex::add(ConfigItem* item, int field)
+{
+  if (this->_count >= this->_capacity)
+  {
+    return false;
+  }
+  this->_entries[this->_count].item = item;
+  this->_entries[this->_count].field = field;
+  this->_count++;
+  return true;
+}
+
+int ItemIndex::indexOf(const char* id)
+{
+  // -- Find the first entry not less than the id.
+  int low = 0;
+  int high = this->_count;
+  while (low < high)
+  {
+    int middle = (low + high) / 2;
+    if (this->compare(&this->_entries[middle], id, false) < 0)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  if ((low < this->_count) && (this->compare(&this->_entries[low], id, false) == 0))
+  {
+    return low;
+  }
+  return -1;
+}
+
+int ItemIndex::compare(Entry* entry, const char* id, bool progmemId)
+{
+  // -- Field ids are PROGMEM strings, these are read byte by byte.
+  bool progmemEntryId = entry->field >= 0;
+  const char* entryId = progmemEntryId ?
+    entry->item->getFieldId(entry->field) : entry->item->getId();
+  while (true)
+  {
+    unsigned char a = progmemEntryId ? pgm_read_byte(entryId) : *entryId;
+    unsigned char b = progmemId ? pgm_read_byte(id) : *id;
+    if ((a != b) || (a == '\0'))
+    {
+      return a - b;
+    }
+    entryId++;
+    id++;
+  }
+}
+
+size_t ConfigItem::memoryReportTo(Stream* out)
+{
+  size_t ram = this->getMemoryUsage();
+  out->print(this->getId());
+  out->print(": RAM ");
+  out->print(ram);
+  out->print(", EEPROM ");
+  out->println(this->getStorageSize());
+  return ram;
+}
+
+ConfigItem* ParameterGroup::findItem(const char* id)
+{
+  ConfigItem* found = ConfigItem::findItem(id);
   ConfigItem* current = this->_firstItem;
-  while (current->_nextItem != nullptr)
+  while ((found == nullptr) && (current != nullptr))
   {
+    found = current->findItem(id);
     current = current->_nextItem;
   }
-  current->_nextItem = configItem;
-  configItem->_parentItem = this;
+  return found;
+}
+
+bool ConfigItem::addToIndex(ItemIndex* index)
+{
+  return (this->_id == nullptr) || index->add(this);
+}
+
+bool ParameterGroup::addToIndex(ItemIndex* index)
+{
+  if (!ConfigItem::addToIndex(index))
+  {
+    return false;
+  }
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    if (!current->addToIndex(index))
+    {
+      return false;
+    }
+    current = current->_nextItem;
+  }
+  return true;
+}
+
+int ParameterGroup::getItemCount()
+{
+  int count = 1;
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    count += current->getItemCount();
+    current = current->_nextItem;
+  }
+  return count;
 }
 
 int ParameterGroup::getStorageSize()
@@ -64,21 +228,32 @@ void ParameterGroup::applyDefaultValue()
 
 void ParameterGroup::storeValue(
   std::function<void(SerializationData* serializationData)> doStore)
+{
+  FunctionSerializer serializer(doStore);
+  this->storeValueTo(serializer);
+}
+void ParameterGroup::loadValue(
+  std::function<void(SerializationData* serializationData)> doLoad)
+{
+  FunctionSerializer serializer(doLoad);
+  this->loadValueFrom(serializer);
+}
+
+void ParameterGroup::storeValueTo(Serializer& serializer)
 {
   ConfigItem* current = this->_firstItem;
   while (current != nullptr)
   {
-    current->storeValue(doStore);
+    current->storeValueTo(serializer);
     current = current->_nextItem;
   }
 }
-void ParameterGroup::loadValue(
-  std::function<void(SerializationData* serializationData)> doLoad)
+void ParameterGroup::loadValueFrom(Serializer& serializer)
 {
   ConfigItem* current = this->_firstItem;
   while (current != nullptr)
   {
-    current->loadValue(doLoad);
+    current->loadValueFrom(serializer);
     current = current->_nextItem;
   }
 }
@@ -128,6 +303,29 @@ void ParameterGroup::clearErrorMessage()
     current = current->_nextItem;
   }
 }
+size_t ParameterGroup::memoryReportTo(Stream* out)
+{
+  size_t ram = ConfigItem::memoryReportTo(out);
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    ram += current->memoryReportTo(out);
+    current = current->_nextItem;
+  }
+  return ram;
+}
+void ParameterGroup::writeJson(JsonWriter* writer)
+{
+  writer->beginObject(this->getId());
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    current->writeJson(writer);
+    current = this->getNextItemOf(current);
+  }
+  writer->endObject();
+}
+
 void ParameterGroup::debugTo(Stream* out)
 {
   out->print('[');
@@ -175,6 +373,20 @@ void ParameterGroup::debugTo(Stream* out)
   }
 }
 
+bool ParameterGroup::loadJsonValue(const char* id, const String& value)
+{
+  ConfigItem* current = this->_firstItem;
+  while (current != nullptr)
+  {
+    if (current->loadJsonValue(id, value))
+    {
+      return true;
+    }
+    current = current->_nextItem;
+  }
+  return false;
+}
+
 #ifdef IOTWEBCONF_ENABLE_JSON
 void ParameterGroup::loadFromJson(JsonObject jsonObject)
 {
@@ -281,6 +493,16 @@ void Parameter::loadFromJson(JsonObject jsonObject)
 }
 #endif
 
+bool Parameter::loadJsonValue(const char* id, const String& value)
+{
+  if (strcmp(id, this->getId()) != 0)
+  {
+    return false;
+  }
+  this->update(value);
+  return true;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -377,6 +599,25 @@ NumberParameter::NumberParameter(
 {
 }
 
+void NumberParameter::refreshValue()
+{
+  this->_intValue = atol(this->valueBuffer);
+  this->_floatValue = atof(this->valueBuffer);
+}
+
+void NumberParameter::applyDefaultValue()
+{
+  TextParameter::applyDefaultValue();
+  this->refreshValue();
+}
+
+void NumberParameter::loadValue(
+  std::function<void(SerializationData* serializationData)> doLoad)
+{
+  TextParameter::loadValue(doLoad);
+  this->refreshValue();
+}
+
 String NumberParameter::renderHtml(
   bool dataArrived,
   bool hasValueFromPost, String valueFromPost)
@@ -384,6 +625,12 @@ String NumberParameter::renderHtml(
   return TextParameter::renderHtml("number", hasValueFromPost, valueFromPost);
 }
 
+void NumberParameter::update(String newValue)
+{
+  TextParameter::update(newValue);
+  this->refreshValue();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 PasswordParameter::PasswordParameter(
@@ -488,6 +735,33 @@ String CheckboxParameter::renderHtml(
   return TextParameter::renderHtml("checkbox", true, "selected");
 }
 
+int CheckboxParameter::getStorageSize()
+{
+  // -- When packed, the value is stored by the group as a single bit.
+  return this->isFlagPacked() ? 0 : TextParameter::getStorageSize();
+}
+
+void CheckboxParameter::storeValueTo(Serializer& serializer)
+{
+  if (!this->isFlagPacked())
+  {
+    TextParameter::storeValueTo(serializer);
+  }
+}
+
+void CheckboxParameter::loadValueFrom(Serializer& serializer)
+{
+  if (!this->isFlagPacked())
+  {
+    TextParameter::loadValueFrom(serializer);
+  }
+}
+
+void CheckboxParameter::setFlagValue(bool value)
+{
+  strncpy(this->valueBuffer, value ? "selected" : "", this->getLength());
+}
+
 void CheckboxParameter::update(WebRequestWrapper* webRequestWrapper)
 {
   if (webRequestWrapper->hasArg(this->getId()))
@@ -16,6 +16,7 @@
 #include <functional>
 #include <IotWebConfSettings.h>
 #include <IotWebConfWebServerWrapper.h>
+#include <IotWebConfJsonWriter.h>
 
 #ifdef IOTWEBCONF_ENABLE_JSON
 # include <ArduinoJson.h>
@@ -47,6 +48,35 @@ typedef struct SerializationData
   int length;
 } SerializationData;
 
+class ItemIndex;
+
+/**
+ * Performs the actual (e.g. EEPROM) access, when values are stored or
+ * loaded. Groups pass it down to their items by reference (see
+ * ConfigItem::storeValueTo()).
+ */
+class Serializer
+{
+public:
+  /**
+   * Stores (or loads) the data. Subsequent calls continue where the
+   * previous one ended.
+   */
+  virtual void serialize(SerializationData* serializationData) = 0;
+
+  /**
+   * Function to be passed to storeValue() and loadValue(). It only
+   * captures a pointer, so std::function keeps it without allocation.
+   */
+  std::function<void(SerializationData* serializationData)> function()
+  {
+    return [this](SerializationData* serializationData)
+    {
+      this->serialize(serializationData);
+    };
+  }
+};
+
 class ConfigItem
 {
 public:
@@ -81,6 +111,26 @@ public:
    */
   virtual void loadValue(std::function<void(SerializationData* serializationData)> doLoad) = 0;
 
+  /**
+   * Save data with the serializer, that is passed by reference. Groups
+   *   override this to pass the serializer down to their items, while the
+   *   default implementation calls storeValue() with serializer.function().
+   *   So parameters only need to implement storeValue(), and groups, that
+   *   store data of their own, should override this method.
+   */
+  virtual void storeValueTo(Serializer& serializer)
+  {
+    this->storeValue(serializer.function());
+  }
+
+  /**
+   * Load data with the serializer. (See storeValueTo().)
+   */
+  virtual void loadValueFrom(Serializer& serializer)
+  {
+    this->loadValue(serializer.function());
+  }
+
   /**
    * This method will create the HTML form item for the config portal.
    * 
@@ -106,6 +156,21 @@ public:
    */
   virtual void clearErrorMessage() = 0;
 
+  /**
+   * Displays an error message at the item after form validation.
+   *   Items without error display ignore the message.
+   */
+  virtual void setErrorMessage(const char* errorMessage) { }
+  /**
+   * Displays an error message at the field with the provided id. Items
+   *   holding fields of their own (e.g. a CompactParameterGroup) override
+   *   this, for others the id is the id of the item.
+   */
+  virtual void setFieldErrorMessage(const char* id, const char* errorMessage)
+  {
+    this->setErrorMessage(errorMessage);
+  }
+
   /**
    * This method should display information to Serial containing the parameter
    *   ID and the current value of the parameter (if it is confidential).
@@ -113,6 +178,17 @@ public:
    */
   virtual void debugTo(Stream* out) = 0;
 
+  /**
+   * Estimated RAM (in bytes) used by this item, sub-items are not included.
+   */
+  virtual size_t getMemoryUsage() { return sizeof(ConfigItem); }
+
+  /**
+   * Prints the RAM and EEPROM usage of this item (and its sub-items) to the
+   *   stream. Returns the RAM used by the item together with its sub-items.
+   */
+  virtual size_t memoryReportTo(Stream* out);
+
 #ifdef IOTWEBCONF_ENABLE_JSON
   /**
    * 
@@ -120,14 +196,83 @@ public:
   virtual void loadFromJson(JsonObject jsonObject) = 0;
 #endif
 
+  /**
+   * Applies a single value of a streamed JSON config (see
+   *   IotWebConf::loadFromJsonStream()). The id is either the id of this
+   *   item, or the id of a value held by this item (e.g. in a
+   *   CompactParameterGroup). Groups offer the value to their sub-items.
+   *   Returns false, if the id is not known here.
+   */
+  virtual bool loadJsonValue(const char* id, const String& value) { return false; }
+
+  /**
+   * Writes the value of the item (and its sub-items) as JSON, keyed by the
+   *   id. Groups are written as nested objects. Passwords should be written
+   *   with JsonWriter::passwordValue().
+   */
+  virtual void writeJson(JsonWriter* writer) { }
+
 protected:
   ConfigItem(const char* id) { this->_id = id; };
 
+  /**
+   * Returns this item (or one of its sub-items) if it has the provided id,
+   *   nullptr otherwise.
+   */
+  virtual ConfigItem* findItem(const char* id)
+  {
+    return (this->_id != nullptr) && (strcmp(this->_id, id) == 0) ? this : nullptr;
+  }
+
+  /**
+   * Number of items, this item included.
+   */
+  virtual int getItemCount() { return 1; }
+
+  /**
+   * Adds the id of this item (and the ids of its sub-items) to the index.
+   *   Returns false, if the index is full.
+   */
+  virtual bool addToIndex(ItemIndex* index);
+
+  /**
+   * Items holding values with ids of their own (e.g. a CompactParameterGroup)
+   *   add these to the index as fields, and provide the field id (a PROGMEM
+   *   string) here.
+   */
+  virtual const char* getFieldId(int field) { return nullptr; }
+
+  /**
+   * Items with a boolean value (checkboxes, the active flag of an
+   *   OptionalParameterGroup) return true here, and provide the value with
+   *   getFlagValue() and setFlagValue(). A FlagGroup stores these values
+   *   packed into a bitfield.
+   */
+  virtual bool isFlag() { return false; }
+  virtual bool getFlagValue() { return false; }
+  virtual void setFlagValue(bool value) { }
+  /**
+   * Groups storing the flags of their sub-items (see FlagGroup) return true.
+   */
+  virtual bool packsFlags() { return false; }
+  /**
+   * True, if the flag of this item is stored by the parent group, so it
+   *   must be left out of the storage of the item.
+   */
+  bool isFlagPacked()
+  {
+    return this->isFlag() &&
+      (this->_parentItem != nullptr) && this->_parentItem->packsFlags();
+  }
+
 private:
   const char* _id = 0;
   ConfigItem* _parentItem = nullptr;
   ConfigItem* _nextItem = nullptr;
   friend class ParameterGroup; // Allow ParameterGroup to access _nextItem.
+  friend class FlagGroup;
+  friend class ItemIndex;
+  friend class IotWebConf;
 };
 
 class ParameterGroup : public ConfigItem
@@ -140,17 +285,27 @@ public:
 #ifdef IOTWEBCONF_ENABLE_JSON
   virtual void loadFromJson(JsonObject jsonObject) override;
 #endif
+  bool loadJsonValue(const char* id, const String& value) override;
+  void writeJson(JsonWriter* writer) override;
 
 protected:
   int getStorageSize() override;
+  /**
+   * Passes the serializer to storeValueTo() (and loadValueFrom()), so
+   * groups should override those instead.
+   */
   void storeValue(std::function<void(
     SerializationData* serializationData)> doStore) override;
   void loadValue(std::function<void(
     SerializationData* serializationData)> doLoad) override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
   void renderHtml(bool dataArrived, WebRequestWrapper* webRequestWrapper) override;
   void update(WebRequestWrapper* webRequestWrapper) override;
   void clearErrorMessage() override;
   void debugTo(Stream* out) override;
+  size_t getMemoryUsage() override { return sizeof(ParameterGroup); }
+  size_t memoryReportTo(Stream* out) override;
   /**
    * One can override this method in case a specific HTML template is required
    * for a group.
@@ -162,7 +317,18 @@ protected:
    */
   virtual String getEndTemplate() { return FPSTR(IOTWEBCONF_HTML_FORM_GROUP_END); };
 
+  ConfigItem* findItem(const char* id) override;
+  int getItemCount() override;
+  bool addToIndex(ItemIndex* index) override;
+  /**
+   * Called after a value of a sub-item (or a deeper item) was applied
+   *   with IotWebConf::applyValue(). The child is the direct sub-item on the
+   *   way to the updated item.
+   */
+  virtual void valueApplied(ConfigItem* child) { }
+
   ConfigItem* _firstItem = nullptr;
+  ConfigItem* _lastItem = nullptr;
   ConfigItem* getNextItemOf(ConfigItem* parent) { return parent->_nextItem; };
 
   friend class IotWebConf; // Allow IotWebConf to access protected members.
@@ -170,6 +336,51 @@ protected:
 private:
 };
 
+/**
+ * Ids of the config items sorted for a binary search. Entries are kept in
+ * an array provided by the owner, so no memory is allocated.
+ */
+class ItemIndex
+{
+public:
+  typedef struct Entry
+  {
+    ConfigItem* item;
+    int16_t field; // -- Negative for the id of the item itself.
+  } Entry;
+
+  ItemIndex(Entry* entries, int capacity) :
+    _entries(entries), _capacity(capacity) { }
+
+  /**
+   * Collects the ids of the root and all its sub-items, and sorts them.
+   *   Returns false (and leaves the index empty), if the ids do not fit.
+   */
+  bool build(ConfigItem* root);
+  bool isBuilt() { return this->_built; }
+  /**
+   * Should only be called from ConfigItem::addToIndex(). Returns false, if
+   *   the index is full.
+   */
+  bool add(ConfigItem* item, int field = -1);
+
+  int getCount() { return this->_count; }
+  /**
+   * Position of the id in the index, or -1 if not found. With duplicate ids
+   *   the first one in the order of the item tree is returned.
+   */
+  int indexOf(const char* id);
+  ConfigItem* getItem(int position) { return this->_entries[position].item; }
+
+private:
+  Entry* _entries;
+  int _capacity;
+  int _count = 0;
+  bool _built = false;
+
+  int compare(Entry* entry, const char* id, bool progmemId);
+};
+
 /**
  * Parameters is a configuration item of the config portal.
  * The parameter will have its input field on the configuration page,
@@ -201,9 +412,18 @@ public:
 
   int getLength() { return this->_length; }
   void applyDefaultValue() override;
+  void setErrorMessage(const char* errorMessage) override
+  {
+    this->errorMessage = errorMessage;
+  }
 #ifdef IOTWEBCONF_ENABLE_JSON
   virtual void loadFromJson(JsonObject jsonObject) override;
 #endif
+  bool loadJsonValue(const char* id, const String& value) override;
+  void writeJson(JsonWriter* writer) override
+  {
+    writer->value(this->getId(), this->valueBuffer);
+  }
 
 protected:
   // Overrides
@@ -213,6 +433,7 @@ protected:
   virtual void update(WebRequestWrapper* webRequestWrapper) override;
   virtual void update(String newValue) = 0;
   void clearErrorMessage() override;
+  size_t getMemoryUsage() override { return sizeof(Parameter) + this->_length; }
 
 private:
   int _length;
@@ -259,6 +480,7 @@ protected:
   virtual void renderHtml(bool dataArrived, WebRequestWrapper* webRequestWrapper) override;
   virtual void update(String newValue) override;
   virtual void debugTo(Stream* out) override;
+  size_t getMemoryUsage() override { return sizeof(TextParameter) + this->getLength(); }
   /**
    * One can override this method in case a specific HTML template is required
    * for a parameter.
@@ -297,6 +519,10 @@ public:
     const char* defaultValue = nullptr,
     const char* placeholder = nullptr,
     const char* customHtml = "ondblclick=\"pw(this.id)\"");
+  void writeJson(JsonWriter* writer) override
+  {
+    writer->passwordValue(this->getId(), this->valueBuffer);
+  }
 
 protected:
   // Overrides
@@ -329,13 +555,28 @@ public:
     const char* placeholder = nullptr,
     const char* customHtml = nullptr);
 
+  /**
+   * The value parsed as a number. Parsed values are cached, these are
+   * refreshed when the value is updated, loaded or set to the default.
+   * Call refreshValue() after modifying valueBuffer directly.
+   */
+  long asInt() { return this->_intValue; }
+  float asFloat() { return this->_floatValue; }
+  void refreshValue();
+
+  void applyDefaultValue() override;
+
 protected:
   // Overrides
+  void loadValue(std::function<void(SerializationData* serializationData)> doLoad) override;
   virtual String renderHtml(
     bool dataArrived, bool hasValueFromPost, String valueFromPost) override;
+  virtual void update(String newValue) override;
 
 private:
   friend class IotWebConf;
+  long _intValue = 0;
+  float _floatValue = 0;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -363,6 +604,12 @@ protected:
   virtual String renderHtml(
     bool dataArrived, bool hasValueFromPost, String valueFromPost) override;
   virtual void update(WebRequestWrapper* webRequestWrapper) override;
+  int getStorageSize() override;
+  void storeValueTo(Serializer& serializer) override;
+  void loadValueFrom(Serializer& serializer) override;
+  bool isFlag() override { return true; }
+  bool getFlagValue() override { return this->isChecked(); }
+  void setFlagValue(bool value) override;
 
 private:
   friend class IotWebConf;
@@ -39,6 +39,97 @@
 # define IOTWEBCONF_DEFAULT_AP_MODE_TIMEOUT_SECS "30"
 #endif
 
+// -- In AP+STA mode the AP is kept alive while connecting to WiFi, and
+// shut down only after the WiFi connection was stable for this time.
+#ifndef IOTWEBCONF_DEFAULT_AP_STA_SHUTDOWN_DELAY_MS
+# define IOTWEBCONF_DEFAULT_AP_STA_SHUTDOWN_DELAY_MS 30000
+#endif
+
+// -- Reconnect policy: delay before retrying after the first failed
+// connection round. (Backoff is only active, when a ReconnectPolicy is set.)
+#ifndef IOTWEBCONF_DEFAULT_RECONNECT_INITIAL_DELAY_MS
+# define IOTWEBCONF_DEFAULT_RECONNECT_INITIAL_DELAY_MS 30000
+#endif
+// -- Reconnect policy: delay is multiplied by this after each failed round.
+#ifndef IOTWEBCONF_DEFAULT_RECONNECT_MULTIPLIER
+# define IOTWEBCONF_DEFAULT_RECONNECT_MULTIPLIER 2.0
+#endif
+// -- Reconnect policy: delay will not grow over this value.
+#ifndef IOTWEBCONF_DEFAULT_RECONNECT_MAX_DELAY_MS
+# define IOTWEBCONF_DEFAULT_RECONNECT_MAX_DELAY_MS 600000
+#endif
+// -- Reconnect policy: delay is randomly modified by this percent, so that
+// many devices will not retry at the very same time.
+#ifndef IOTWEBCONF_DEFAULT_RECONNECT_JITTER_PERCENT
+# define IOTWEBCONF_DEFAULT_RECONNECT_JITTER_PERCENT 20
+#endif
+
+// -- Roaming: signal strength (dBm) under which we look for a better access
+// point. (Roaming is only active, when a RoamingPolicy is set.)
+#ifndef IOTWEBCONF_DEFAULT_ROAMING_RSSI_THRESHOLD
+# define IOTWEBCONF_DEFAULT_ROAMING_RSSI_THRESHOLD -75
+#endif
+// -- Roaming: a candidate access point must be this much (dB) stronger than
+// the current one.
+#ifndef IOTWEBCONF_DEFAULT_ROAMING_RSSI_HYSTERESIS
+# define IOTWEBCONF_DEFAULT_ROAMING_RSSI_HYSTERESIS 8
+#endif
+// -- Roaming: time between signal strength samples.
+#ifndef IOTWEBCONF_DEFAULT_ROAMING_SAMPLE_INTERVAL_MS
+# define IOTWEBCONF_DEFAULT_ROAMING_SAMPLE_INTERVAL_MS 10000
+#endif
+// -- Roaming: minimal time between two background scans.
+#ifndef IOTWEBCONF_DEFAULT_ROAMING_SCAN_INTERVAL_MS
+# define IOTWEBCONF_DEFAULT_ROAMING_SCAN_INTERVAL_MS 60000
+#endif
+// -- Roaming: minimal time to stay connected to an access point before
+// roaming away from it.
+#ifndef IOTWEBCONF_DEFAULT_ROAMING_MIN_DWELL_MS
+# define IOTWEBCONF_DEFAULT_ROAMING_MIN_DWELL_MS 120000
+#endif
+
+// -- Warm boot: with IOTWEBCONF_ENABLE_WARM_BOOT defined, a snapshot of the
+// configuration and of the last WiFi connection is kept in RTC memory, so
+// after deep sleep the configuration is restored without reading the flash.
+// This is the maximal size of the configuration data in the snapshot. (The
+// snapshot takes 88 bytes more, the default fits blocks 32-99.)
+#ifndef IOTWEBCONF_WARM_BOOT_DATA_SIZE
+# define IOTWEBCONF_WARM_BOOT_DATA_SIZE 184
+#endif
+// -- Warm boot: offset of the snapshot in the ESP8266 RTC user memory
+// (in 4 byte blocks). The first 32 blocks are used by the OTA update (eboot
+// command), blocks from 100 are left for the state trace.
+#ifndef IOTWEBCONF_WARM_BOOT_RTC_OFFSET
+# define IOTWEBCONF_WARM_BOOT_RTC_OFFSET 32
+#endif
+
+// -- Records microsecond timestamps of the boot phases if enabled. See
+// IotWebConf::getBootPhaseMicros().
+//#define IOTWEBCONF_ENABLE_BOOT_PROFILER
+
+// -- State trace: with IOTWEBCONF_ENABLE_STATE_TRACE defined, the last
+// network state changes are recorded with their causes. This is the number
+// of records kept (each takes 24 bytes by default).
+#ifndef IOTWEBCONF_STATE_TRACE_SIZE
+# ifdef IOTWEBCONF_ENABLE_STATE_TRACE_RTC
+#  define IOTWEBCONF_STATE_TRACE_SIZE 4
+# else
+#  define IOTWEBCONF_STATE_TRACE_SIZE 8
+# endif
+#endif
+// -- State trace: SSIDs are recorded up to this length (terminating zero
+// included), longer ones are truncated.
+#ifndef IOTWEBCONF_STATE_TRACE_SSID_LEN
+# define IOTWEBCONF_STATE_TRACE_SSID_LEN 17
+#endif
+// -- State trace: with IOTWEBCONF_ENABLE_STATE_TRACE_RTC also defined, the
+// records survive soft resets in RTC memory. This is the offset of the trace
+// in the ESP8266 RTC user memory (in 4 byte blocks). The default trace (108
+// bytes) fits blocks 100-127, after the warm boot snapshot.
+#ifndef IOTWEBCONF_STATE_TRACE_RTC_OFFSET
+# define IOTWEBCONF_STATE_TRACE_RTC_OFFSET 100
+#endif
+
 // -- mDNS should allow you to connect to this device with a hostname provided
 // by the device. E.g. mything.local
 // (This is not very likely to work, and MDNS is not very well documented.)
@@ -54,6 +145,51 @@
 // -- Logs passwords to Serial if enabled.
 //#define IOTWEBCONF_DEBUG_PWD_TO_SERIAL
 
+// -- HTTPUpdateClient: time between two manifest checks.
+#ifndef IOTWEBCONF_UPDATE_CLIENT_CHECK_INTERVAL_MS
+# define IOTWEBCONF_UPDATE_CLIENT_CHECK_INTERVAL_MS 3600000
+#endif
+// -- HTTPUpdateClient: request is given up, when no data arrives for this time.
+#ifndef IOTWEBCONF_UPDATE_CLIENT_TIMEOUT_MS
+# define IOTWEBCONF_UPDATE_CLIENT_TIMEOUT_MS 10000
+#endif
+// -- HTTPUpdateClient: maximal amount of bytes processed in one doLoop() call.
+// This is also the maximal size of the manifest.
+#ifndef IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE
+# define IOTWEBCONF_UPDATE_CLIENT_BUFFER_SIZE 1024
+#endif
+// -- HTTPUpdateClient: longer response header lines are truncated.
+#ifndef IOTWEBCONF_UPDATE_CLIENT_MAX_LINE_LEN
+# define IOTWEBCONF_UPDATE_CLIENT_MAX_LINE_LEN 128
+#endif
+
+// -- Maximal number of distinct form fields read by the constraints during
+// a form validation (see IotWebConf::addConstraint()). Values are kept on
+// the stack while validating.
+#ifndef IOTWEBCONF_FORM_SNAPSHOT_SIZE
+# define IOTWEBCONF_FORM_SNAPSHOT_SIZE 16
+#endif
+
+// -- Maximal number of ids in the item index (see IotWebConf::findItem()),
+// each taking 8 bytes. With more items, these are looked up by walking the
+// item tree.
+#ifndef IOTWEBCONF_ITEM_INDEX_SIZE
+# define IOTWEBCONF_ITEM_INDEX_SIZE 32
+#endif
+
+// -- Streamed JSON config: maximal nesting of objects and arrays.
+#ifndef IOTWEBCONF_JSON_MAX_DEPTH
+# define IOTWEBCONF_JSON_MAX_DEPTH 8
+#endif
+// -- Streamed JSON config: keys longer than this will not match any item.
+#ifndef IOTWEBCONF_JSON_MAX_KEY_LEN
+# define IOTWEBCONF_JSON_MAX_KEY_LEN 32
+#endif
+// -- Streamed JSON config: a longer value fails the read.
+#ifndef IOTWEBCONF_JSON_MAX_VALUE_LEN
+# define IOTWEBCONF_JSON_MAX_VALUE_LEN 256
+#endif
+
 // -- Helper define for serial debug
 #ifdef IOTWEBCONF_DEBUG_TO_SERIAL
 # define IOTWEBCONF_DEBUG_LINE(MSG) Serial.println(MSG)
@@ -70,4 +206,9 @@
 # define IOTWEBCONF_DNS_PORT 53
 #endif
 
+// -- Maximal number of DNS queries answered by DnsResponder in one doLoop().
+#ifndef IOTWEBCONF_DNS_PACKET_BUDGET
+# define IOTWEBCONF_DNS_PACKET_BUDGET 8
+#endif
+
 #endif
\ No newline at end of file
@@ -74,6 +74,19 @@ public:
     }
   }
 #endif
+  bool loadJsonValue(const char* id, const String& value) override
+  {
+    if (strcmp(id, this->getId()) != 0)
+    {
+      return false;
+    }
+    this->update(value);
+    return true;
+  }
+  void writeJson(JsonWriter* writer) override
+  {
+    writer->value(this->getId(), this->toString().c_str());
+  }
 
 protected:
   ConfigItemBridge(const char* id) : ConfigItem(id) { }
@@ -420,12 +433,21 @@ public:
   }
 
   const char* errorMessage = nullptr;
+  void setErrorMessage(const char* errorMessage) override
+  {
+    this->errorMessage = errorMessage;
+  }
 
 protected:
   void clearErrorMessage() override
   {
     this->errorMessage = nullptr;
   }
+  // -- Estimation: the value is kept in the data type part of the parameter.
+  size_t getMemoryUsage() override
+  {
+    return sizeof(InputParameter) + this->getStorageSize();
+  }
 
   virtual String renderHtml(
     bool dataArrived, bool hasValueFromPost, String valueFromPost)
@@ -504,6 +526,29 @@ public:
 protected:
   virtual const char* getInputType() override { return "checkbox"; }
 
+  // -- When packed, the value is stored by the group as a single bit.
+  int getStorageSize() override
+  {
+    return this->isFlagPacked() ? 0 : BoolDataType::getStorageSize();
+  }
+  void storeValueTo(Serializer& serializer) override
+  {
+    if (!this->isFlagPacked())
+    {
+      BoolDataType::storeValueTo(serializer);
+    }
+  }
+  void loadValueFrom(Serializer& serializer) override
+  {
+    if (!this->isFlagPacked())
+    {
+      BoolDataType::loadValueFrom(serializer);
+    }
+  }
+  bool isFlag() override { return true; }
+  bool getFlagValue() override { return this->_value; }
+  void setFlagValue(bool value) override { this->_value = value; }
+
   virtual void update(WebRequestWrapper* webRequestWrapper) override
   {
       bool selected = false;
@@ -582,6 +627,11 @@ using CharArrayDataType<len>::CharArrayDataType;
 #endif
   }
 
+  void writeJson(JsonWriter* writer) override
+  {
+    writer->passwordValue(this->getId(), this->_value);
+  }
+
   virtual bool update(String newValue, bool validateOnly) override
   {
     if (newValue.length() + 1 > len)
@@ -0,0 +1,222 @@
+/**
+ * IotWebConfTSchema.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfTSchema_h
+#define IotWebConfTSchema_h
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <IotWebConfTParameter.h>
+
+// -- Maximal storage size of a schema group, checked at compile time.
+#ifndef IOTWEBCONF_TSCHEMA_STORAGE_BUDGET
+# define IOTWEBCONF_TSCHEMA_STORAGE_BUDGET \
+  (4096 - IOTWEBCONF_CONFIG_START - IOTWEBCONF_CONFIG_VERSION_LENGTH)
+#endif
+
+namespace iotwebconf
+{
+
+/**
+ * Type of the value stored by a typed parameter.
+ */
+template <typename ParamType>
+using TSchemaValueType =
+  typename std::remove_reference<decltype(std::declval<ParamType&>().value())>::type;
+
+/**
+ * Storage size of the first 'count' parameters of the list.
+ */
+template <size_t count, typename... ParamTypes>
+struct TSchemaSize
+{
+  static constexpr int value = 0;
+};
+
+template <size_t count, typename ParamType, typename... ParamTypes>
+struct TSchemaSize<count, ParamType, ParamTypes...>
+{
+  static constexpr int value = (count == 0) ? 0 :
+    sizeof(TSchemaValueType<ParamType>) +
+    TSchemaSize<(count == 0) ? 0 : count - 1, ParamTypes...>::value;
+};
+
+/**
+ * FNV-1a hash of an id. Being constexpr, hashes of literal ids are computed
+ * by the compiler.
+ */
+constexpr uint32_t tSchemaIdHash(const char* id, uint32_t hash = 2166136261u)
+{
+  return (*id == '\0') ? hash :
+    tSchemaIdHash(id + 1, (hash ^ (uint8_t)*id) * 16777619u);
+}
+
+/**
+ * Smallest power of two not less than the value.
+ */
+constexpr size_t tSchemaTableSize(size_t value, size_t size = 1)
+{
+  return (size >= value) ? size : tSchemaTableSize(value, size * 2);
+}
+
+/**
+ * A parameter group with a storage layout fixed at compile time. The typed
+ * parameters are listed as template arguments, so the storage size and the
+ * offset of each parameter are constants, and the size is checked against
+ * IOTWEBCONF_TSCHEMA_STORAGE_BUDGET. Storing and loading the values is
+ * unrolled at compile time, without calling the parameters virtually.
+ *
+ * Ids of the parameters are looked up in a hash table, sized at compile
+ * time to twice the parameter count (see findItem() and indexOf()).
+ *
+ * Only parameters with trivially copyable values (numbers, bool, char arrays)
+ * can be part of a schema. The storage layout is the same as that of a
+ * ParameterGroup with the same parameters.
+ *
+ * Example:
+ *   iotwebconf::IntTParameter<int16_t> intParam = ...;
+ *   iotwebconf::FloatTParameter floatParam = ...;
+ *   iotwebconf::TSchemaGroup<
+ *     iotwebconf::IntTParameter<int16_t>, iotwebconf::FloatTParameter>
+ *       group("group", "Group", intParam, floatParam);
+ */
+template <typename... ParamTypes>
+class TSchemaGroup : public ParameterGroup
+{
+public:
+  static constexpr int StorageSize =
+    TSchemaSize<sizeof...(ParamTypes), ParamTypes...>::value;
+
+  /**
+   * Offset of the value of the parameter at the provided index, relative to
+   * the start of the group.
+   */
+  template <size_t index>
+  static constexpr int offsetOf()
+  {
+    static_assert(index < sizeof...(ParamTypes), "Parameter index out of range.");
+    return TSchemaSize<index, ParamTypes...>::value;
+  }
+
+  static_assert(StorageSize <= IOTWEBCONF_TSCHEMA_STORAGE_BUDGET,
+    "Schema group does not fit into the storage budget.");
+  static_assert(sizeof...(ParamTypes) < 255,
+    "Too many parameters for the id hash table.");
+
+  static constexpr size_t HashTableSize =
+    tSchemaTableSize(2 * sizeof...(ParamTypes));
+
+  TSchemaGroup(const char* id, const char* label, ParamTypes&... params) :
+    ParameterGroup(id, label), _params(params...)
+  {
+    this->addItems(params...);
+    for (size_t i = 0; i < sizeof...(ParamTypes); i++)
+    {
+      size_t slot = tSchemaIdHash(this->itemAt<0>(i)->getId()) & (HashTableSize - 1);
+      while (this->_hashTable[slot] != 0)
+      {
+        slot = (slot + 1) & (HashTableSize - 1);
+      }
+      this->_hashTable[slot] = i + 1;
+    }
+  }
+
+  /**
+   * Index of the parameter with the provided id in the template argument
+   *   list, or -1 if no parameter has this id.
+   */
+  int indexOf(const char* id)
+  {
+    size_t slot = tSchemaIdHash(id) & (HashTableSize - 1);
+    while (this->_hashTable[slot] != 0)
+    {
+      int index = this->_hashTable[slot] - 1;
+      if (strcmp(this->itemAt<0>(index)->getId(), id) == 0)
+      {
+        return index;
+      }
+      slot = (slot + 1) & (HashTableSize - 1);
+    }
+    return -1;
+  }
+
+protected:
+  int getStorageSize() override { return StorageSize; }
+  ConfigItem* findItem(const char* id) override
+  {
+    int index = this->indexOf(id);
+    if (index >= 0)
+    {
+      return this->itemAt<0>(index);
+    }
+    return ConfigItem::findItem(id);
+  }
+  void storeValueTo(Serializer& serializer) override
+  {
+    this->serializeFrom<0>(serializer);
+  }
+  void loadValueFrom(Serializer& serializer) override
+  {
+    // -- Values are trivially copyable, so these can be loaded in place.
+    this->serializeFrom<0>(serializer);
+  }
+
+private:
+  std::tuple<ParamTypes&...> _params;
+  uint8_t _hashTable[HashTableSize] = { 0 };
+
+  template <size_t index>
+  typename std::enable_if<(index == sizeof...(ParamTypes)), ConfigItem*>::type
+    itemAt(size_t position) { return nullptr; }
+  template <size_t index>
+  typename std::enable_if<(index < sizeof...(ParamTypes)), ConfigItem*>::type
+    itemAt(size_t position)
+  {
+    return (position == index) ?
+      &std::get<index>(this->_params) : this->itemAt<index + 1>(position);
+  }
+
+  void addItems() { }
+  template <typename ParamType, typename... Rest>
+  void addItems(ParamType& param, Rest&... rest)
+  {
+    static_assert(
+      std::is_trivially_copyable<TSchemaValueType<ParamType>>::value,
+      "Only parameters with trivially copyable values can be part of a schema.");
+    this->addItem(&param);
+    this->addItems(rest...);
+  }
+
+  template <size_t index>
+  typename std::enable_if<(index == sizeof...(ParamTypes))>::type
+    serializeFrom(Serializer& serializer) { }
+  template <size_t index>
+  typename std::enable_if<(index < sizeof...(ParamTypes))>::type
+    serializeFrom(Serializer& serializer)
+  {
+    auto& value = std::get<index>(this->_params).value();
+    SerializationData serializationData;
+    serializationData.length = sizeof(value);
+    serializationData.data = reinterpret_cast<byte*>(&value);
+    serializer.serialize(&serializationData);
+    this->serializeFrom<index + 1>(serializer);
+  }
+};
+
+template <typename... ParamTypes>
+constexpr int TSchemaGroup<ParamTypes...>::StorageSize;
+template <typename... ParamTypes>
+constexpr size_t TSchemaGroup<ParamTypes...>::HashTableSize;
+
+} // end namespace
+
+#endif
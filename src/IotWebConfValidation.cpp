@@ -0,0 +1,218 @@
+/**
+ * IotWebConfValidation.cpp -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include "IotWebConfValidation.h"
+
+namespace
+{
+
+/**
+ * Returns the end of the pattern atom (character, escape or class) starting
+ * at the pattern.
+ */
+const char* atomEnd(const char* pattern)
+{
+  if (*pattern == '\\')
+  {
+    return pattern[1] != '\0' ? pattern + 2 : pattern + 1;
+  }
+  if (*pattern == '[')
+  {
+    const char* current = pattern + 1;
+    if (*current == '^')
+    {
+      current++;
+    }
+    if (*current == ']')
+    {
+      // -- A leading ']' is a literal.
+      current++;
+    }
+    while ((*current != '\0') && (*current != ']'))
+    {
+      current++;
+    }
+    return *current != '\0' ? current + 1 : current;
+  }
+  return pattern + 1;
+}
+
+bool atomMatches(const char* atom, const char* end, char c)
+{
+  if (*atom == '.')
+  {
+    return true;
+  }
+  if (*atom == '\\')
+  {
+    switch (atom[1])
+    {
+      case 'd':
+        return isdigit(c);
+      case 'w':
+        return isalnum(c) || (c == '_');
+      case 's':
+        return isspace(c);
+      default:
+        return c == atom[1];
+    }
+  }
+  if (*atom == '[')
+  {
+    const char* current = atom + 1;
+    bool negate = (*current == '^');
+    if (negate)
+    {
+      current++;
+    }
+    const char* last = (*(end - 1) == ']') ? end - 1 : end;
+    bool found = false;
+    while (current < last)
+    {
+      if ((current + 2 < last) && (current[1] == '-'))
+      {
+        found |= (current[0] <= c) && (c <= current[2]);
+        current += 3;
+      }
+      else
+      {
+        found |= (*current == c);
+        current++;
+      }
+    }
+    return found != negate;
+  }
+  return c == *atom;
+}
+
+bool matchHere(const char* pattern, const char* text)
+{
+  if (*pattern == '\0')
+  {
+    return *text == '\0';
+  }
+  const char* end = atomEnd(pattern);
+  char quantifier = *end;
+  if ((quantifier == '*') || (quantifier == '+') || (quantifier == '?'))
+  {
+    int min = (quantifier == '+') ? 1 : 0;
+    int max = (quantifier == '?') ? 1 : INT_MAX;
+    int count = 0;
+    while ((count < max) && (text[count] != '\0') &&
+      atomMatches(pattern, end, text[count]))
+    {
+      count++;
+    }
+    // -- Greedy, backtrack on failure.
+    for (; count >= min; count--)
+    {
+      if (matchHere(end + 1, text + count))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+  return (*text != '\0') &&
+    atomMatches(pattern, end, *text) && matchHere(end, text + 1);
+}
+
+} // end anonymous namespace
+
+namespace iotwebconf
+{
+
+FormSnapshot::Entry* FormSnapshot::find(const char* id)
+{
+  for (int i = 0; i < this->_count; i++)
+  {
+    Entry* entry = &this->_entries[i];
+    if ((entry->id == id) || (strcmp(entry->id, id) == 0))
+    {
+      return entry;
+    }
+  }
+
+  // -- First access, fetch from the request. Entries already handed out
+  // must stay intact, so a full snapshot does not take new ids.
+  if (this->_count >= this->_capacity)
+  {
+    this->_overflowed = true;
+    return nullptr;
+  }
+  Entry* entry = &this->_entries[this->_count++];
+  entry->id = id;
+  entry->has = this->_webRequestWrapper->hasArg(id);
+  entry->failed = false;
+  entry->value = entry->has ? this->_webRequestWrapper->arg(id) : String();
+  return entry;
+}
+
+bool FormSnapshot::has(const char* id)
+{
+  Entry* entry = this->find(id);
+  return (entry != nullptr) && entry->has;
+}
+
+const String& FormSnapshot::get(const char* id)
+{
+  Entry* entry = this->find(id);
+  return entry != nullptr ? entry->value : this->_missing;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool LengthConstraint::check(FormSnapshot* form)
+{
+  unsigned int length = form->get(this->getId()).length();
+  if ((length == 0) && this->_allowEmpty)
+  {
+    return true;
+  }
+  return (this->_minLength <= length) &&
+    ((this->_maxLength == 0) || (length <= this->_maxLength));
+}
+
+bool RangeConstraint::check(FormSnapshot* form)
+{
+  const String& value = form->get(this->getId());
+  if (value.length() == 0)
+  {
+    return this->_allowEmpty;
+  }
+  char* end;
+  double number = strtod(value.c_str(), &end);
+  if (*end != '\0')
+  {
+    // -- Not a number.
+    return false;
+  }
+  return (this->_min <= number) && (number <= this->_max);
+}
+
+bool PatternConstraint::check(FormSnapshot* form)
+{
+  const String& value = form->get(this->getId());
+  if ((value.length() == 0) && this->_allowEmpty)
+  {
+    return true;
+  }
+  return PatternConstraint::matches(this->_pattern, value.c_str());
+}
+
+bool PatternConstraint::matches(const char* pattern, const char* text)
+{
+  return matchHere(pattern, text);
+}
+
+} // end namespace
@@ -0,0 +1,189 @@
+/**
+ * IotWebConfValidation.h -- IotWebConf is an ESP8266/ESP32
+ *   non blocking WiFi/AP web configuration library for Arduino.
+ *   https://github.com/prampec/IotWebConf
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef IotWebConfValidation_h
+#define IotWebConfValidation_h
+
+#include <functional>
+#include "IotWebConfParameter.h"
+#include "IotWebConfWebServerWrapper.h"
+
+namespace iotwebconf
+{
+
+/**
+ * Values of a form post. Each argument is fetched from the request only once,
+ * on first access, and then kept until the validation is finished. Values are
+ * kept in an array of IOTWEBCONF_FORM_SNAPSHOT_SIZE entries. When more
+ * fields are read, the extra ones are reported as missing, and the
+ * validation fails.
+ */
+class FormSnapshot
+{
+public:
+  bool has(const char* id);
+  const String& get(const char* id);
+  /**
+   * True, if a field could not be kept, because the snapshot was full.
+   */
+  bool isOverflowed() { return this->_overflowed; }
+
+private:
+  typedef struct Entry
+  {
+    const char* id;
+    bool has;
+    bool failed;
+    String value;
+  } Entry;
+
+  FormSnapshot(WebRequestWrapper* webRequestWrapper, Entry* entries, int capacity) :
+    _webRequestWrapper(webRequestWrapper), _entries(entries), _capacity(capacity) { }
+  FormSnapshot(const FormSnapshot&) = delete;
+  FormSnapshot& operator=(const FormSnapshot&) = delete;
+
+  /**
+   * Returns nullptr, if the id is new, and there is no room for it.
+   */
+  Entry* find(const char* id);
+
+  WebRequestWrapper* _webRequestWrapper;
+  Entry* _entries;
+  int _capacity;
+  int _count = 0;
+  bool _overflowed = false;
+  String _missing;
+  friend class IotWebConf;
+};
+
+/**
+ * A declarative validation rule of a config item. Constraints are registered
+ * with IotWebConf::addConstraint(), and all of them are checked against the
+ * posted form in a single pass. When a constraint fails, its error message is
+ * displayed at the item. Only the first failing constraint of an item is
+ * reported.
+ */
+class Constraint
+{
+public:
+  Constraint(ConfigItem* item, const char* errorMessage) :
+    _item(item), _errorMessage(errorMessage) { }
+  ConfigItem* getItem() { return this->_item; }
+  const char* getErrorMessage() { return this->_errorMessage; }
+  /**
+   * Targets a field of the item (e.g. a parameter of a
+   *   CompactParameterGroup) instead of the item itself. The id must be a
+   *   string in RAM.
+   */
+  void setFieldId(const char* fieldId) { this->_fieldId = fieldId; }
+  /**
+   * Id of the checked form field, the id of the item, if no field was set.
+   */
+  const char* getId()
+  {
+    return this->_fieldId != nullptr ? this->_fieldId : this->_item->getId();
+  }
+
+  /**
+   * Returns true, if the posted value(s) satisfy the constraint.
+   */
+  virtual bool check(FormSnapshot* form) = 0;
+
+private:
+  ConfigItem* _item;
+  const char* _errorMessage;
+  const char* _fieldId = nullptr;
+  Constraint* _nextConstraint = nullptr;
+  friend class IotWebConf;
+};
+
+/**
+ * Length of the value must be between minLength and maxLength (inclusive).
+ * A maxLength of 0 means no upper limit. With allowEmpty an empty value
+ * is accepted as well (e.g. password is not changed).
+ */
+class LengthConstraint : public Constraint
+{
+public:
+  LengthConstraint(
+    ConfigItem* item, const char* errorMessage,
+    unsigned int minLength, unsigned int maxLength = 0, bool allowEmpty = false) :
+    Constraint(item, errorMessage),
+    _minLength(minLength), _maxLength(maxLength), _allowEmpty(allowEmpty) { }
+  bool check(FormSnapshot* form) override;
+
+private:
+  unsigned int _minLength;
+  unsigned int _maxLength;
+  bool _allowEmpty;
+};
+
+/**
+ * The value must be a number between min and max (inclusive).
+ */
+class RangeConstraint : public Constraint
+{
+public:
+  RangeConstraint(
+    ConfigItem* item, const char* errorMessage,
+    double min, double max, bool allowEmpty = false) :
+    Constraint(item, errorMessage),
+    _min(min), _max(max), _allowEmpty(allowEmpty) { }
+  bool check(FormSnapshot* form) override;
+
+private:
+  double _min;
+  double _max;
+  bool _allowEmpty;
+};
+
+/**
+ * The whole value must match a simple pattern. Supported are: literal
+ * characters, '.', character classes like [a-z0-9_] and [^,], the escapes
+ * \d, \w, \s and escaped literals, followed by an optional '*', '+' or '?'.
+ */
+class PatternConstraint : public Constraint
+{
+public:
+  PatternConstraint(
+    ConfigItem* item, const char* errorMessage,
+    const char* pattern, bool allowEmpty = false) :
+    Constraint(item, errorMessage),
+    _pattern(pattern), _allowEmpty(allowEmpty) { }
+  bool check(FormSnapshot* form) override;
+
+  static bool matches(const char* pattern, const char* text);
+
+private:
+  const char* _pattern;
+  bool _allowEmpty;
+};
+
+/**
+ * Custom rule, e.g. across multiple fields. The rule can read any posted
+ * value from the form. The error message is displayed at the provided item.
+ */
+class RuleConstraint : public Constraint
+{
+public:
+  RuleConstraint(
+    ConfigItem* item, const char* errorMessage,
+    std::function<bool(FormSnapshot* form)> rule) :
+    Constraint(item, errorMessage), _rule(rule) { }
+  bool check(FormSnapshot* form) override { return this->_rule(form); }
+
+private:
+  std::function<bool(FormSnapshot* form)> _rule;
+};
+
+} // end namespace
+
+#endif
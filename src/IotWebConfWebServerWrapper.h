@@ -29,6 +29,13 @@ public:
   virtual void requestAuthentication();
   virtual bool hasArg(const String& name);
   virtual String arg(const String name);
+  /**
+   * Access to the arguments by position. Wrappers not supporting this
+   *   return -1 for args(), arguments are then only queried by name.
+   */
+  virtual int args() { return -1; }
+  virtual String argName(int i) { return String(); }
+  virtual String arg(int i) { return String(); }
   virtual void sendHeader(const String& name, const String& value, bool first = false);
   virtual void setContentLength(const size_t contentLength);
   virtual void send(int code, const char* content_type = nullptr, const String& content = String(""));
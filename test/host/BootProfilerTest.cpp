@@ -0,0 +1,118 @@
+/**
+ * BootProfilerTest.cpp -- Boot profile of IotWebConf on the virtual clock,
+ *   with simulated EEPROM and Serial costs.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Simulation.h"
+#include <EEPROM.h>
+
+using namespace iotwebconf;
+using host::SimulatedThing;
+
+namespace
+{
+void printProfile(IotWebConf* iotWebConf)
+{
+  unsigned long previous = iotWebConf->getBootPhaseMicros(BootPhaseInitStart);
+  for (int i = 0; i < BootPhaseCount; i++)
+  {
+    unsigned long timestamp = iotWebConf->getBootPhaseMicros((BootPhase)i);
+    printf("  %-13s %10lu us  +%lu us\n",
+      IotWebConf::getBootPhaseName((BootPhase)i), timestamp,
+      timestamp > 0 ? timestamp - previous : 0);
+    if (timestamp > 0)
+    {
+      previous = timestamp;
+    }
+  }
+}
+} // end anonymous namespace
+
+HOST_TEST(allPhasesAreRecordedInOrder)
+{
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  // -- Costs of a typical ESP32: the EEPROM sector is loaded from NVS on
+  // begin(), and the config dump goes out on 115200 baud.
+  EEPROM.beginMicros = 4000;
+  EEPROM.readMicros = 1;
+  host::setSerialMicrosPerByte(87);
+
+  SimulatedThing thing;
+  thing.iotWebConf.skipApStartup();
+  CHECK(thing.iotWebConf.init());
+  for (int i = BootPhaseInitStart; i <= BootPhaseInitDone; i++)
+  {
+    CHECK(thing.iotWebConf.getBootPhaseMicros((BootPhase)i) > 0);
+  }
+  CHECK_EQ(0ul, thing.iotWebConf.getBootPhaseMicros(BootPhaseFirstState));
+
+  CHECK(thing.runUntil(OnLine, 5000));
+  printProfile(&thing.iotWebConf);
+  unsigned long previous = 0;
+  for (int i = 0; i < BootPhaseCount; i++)
+  {
+    unsigned long timestamp = thing.iotWebConf.getBootPhaseMicros((BootPhase)i);
+    CHECK(timestamp >= previous);
+    previous = timestamp;
+  }
+
+  auto phaseMicros = [&](BootPhase phase)
+  {
+    return thing.iotWebConf.getBootPhaseMicros(phase) -
+      thing.iotWebConf.getBootPhaseMicros((BootPhase)(phase - 1));
+  };
+  CHECK_EQ(4000ul, phaseMicros(BootPhaseEepromOpened));
+  // -- Every byte of the config is read once.
+  CHECK(phaseMicros(BootPhaseValuesLoaded) >= 100);
+  // -- Config dump to Serial is the most expensive part of init().
+  CHECK(phaseMicros(BootPhaseConfigDumped) > 10000);
+  // -- Connecting takes 2 s of simulated WiFi time, noticed by the next
+  // doLoop() (10 ms step) after the state change was logged.
+  CHECK(phaseMicros(BootPhaseOnLine) >= 2000000);
+  CHECK(phaseMicros(BootPhaseOnLine) < 2020000);
+}
+
+HOST_TEST(phasesAreOnlyRecordedOnce)
+{
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+  CHECK(thing.runUntil(OnLine, 5000));
+  unsigned long onLine = thing.iotWebConf.getBootPhaseMicros(BootPhaseOnLine);
+  unsigned long connecting = thing.iotWebConf.getBootPhaseMicros(BootPhaseConnecting);
+
+  WiFi.dropConnection();
+  thing.runFor(1000);
+  WiFi.setInRange("home", true);
+  CHECK(thing.runUntil(OnLine, 5000));
+  CHECK_EQ(connecting, thing.iotWebConf.getBootPhaseMicros(BootPhaseConnecting));
+  CHECK_EQ(onLine, thing.iotWebConf.getBootPhaseMicros(BootPhaseOnLine));
+}
+
+HOST_TEST(profileIsServedAsText)
+{
+  SimulatedThing thing;
+  thing.server.on("/boot", [&]() { thing.iotWebConf.handleBootProfile(); });
+  thing.iotWebConf.init();
+  thing.runFor(100);
+
+  const WebServer::Response& response = thing.server.request(HTTP_GET, "/boot");
+  CHECK_EQ(200, response.code);
+  CHECK(response.contentType == "text/plain");
+  // -- Without a config the Thing stays in AP mode: no connection phases.
+  CHECK(response.content.startsWith("initStart 1000 +0\n"));
+  CHECK(response.content.indexOf("firstState 11000 +10000\n") > 0);
+  CHECK(response.content.endsWith("connecting -\nonLine -\n"));
+  CHECK(response.header("Cache-Control").startsWith("no-cache"));
+}
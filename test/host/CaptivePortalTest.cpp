@@ -0,0 +1,230 @@
+/**
+ * CaptivePortalTest.cpp -- DnsResponder replies and the connectivity check
+ *   (probe) redirects of the captive portal, with their latency on the host.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Simulation.h"
+#include <vector>
+
+using namespace iotwebconf;
+using host::SimulatedThing;
+
+namespace
+{
+
+typedef std::vector<uint8_t> Packet;
+
+// -- Exposes the reply building of the responder.
+class TestDnsResponder : public DnsResponder
+{
+public:
+  TestDnsResponder() { this->start(53, IPAddress(192, 168, 4, 1)); }
+  size_t reply(const Packet& query)
+  {
+    memcpy(this->_buffer, query.data(), query.size());
+    return this->buildReply(query.size());
+  }
+  Packet lastReply(size_t length) { return Packet(this->_buffer, this->_buffer + length); }
+};
+
+// -- A standard query (recursion desired) with a single question.
+Packet makeQuery(const char* name, uint16_t type)
+{
+  Packet query = { 0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  const char* label = name;
+  while (*label != '\0')
+  {
+    const char* dot = strchr(label, '.');
+    size_t length = dot == nullptr ? strlen(label) : dot - label;
+    query.push_back(length);
+    query.insert(query.end(), label, label + length);
+    label += length + (dot == nullptr ? 0 : 1);
+  }
+  query.push_back(0);
+  query.push_back(type >> 8);
+  query.push_back(type & 0xFF);
+  query.push_back(0x00);
+  query.push_back(0x01);
+  return query;
+}
+
+// -- EDNS OPT pseudo record as sent by most resolvers.
+void addEdns(Packet* query)
+{
+  (*query)[11] = 1;
+  const uint8_t opt[] = { 0x00, 0x00, 0x29, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  query->insert(query->end(), opt, opt + sizeof(opt));
+}
+
+// -- Connectivity checks of the operating systems: host and uri.
+const char* const Probes[][2] = {
+  { "connectivitycheck.gstatic.com", "/generate_204" },
+  { "clients3.google.com", "/gen_204" },
+  { "captive.apple.com", "/hotspot-detect.html" },
+  { "www.apple.com", "/library/test/success.html" },
+  { "www.msftconnecttest.com", "/connecttest.txt" },
+  { "www.msftncsi.com", "/ncsi.txt" },
+  { "detectportal.firefox.com", "/success.txt" },
+  { "detectportal.firefox.com", "/canonical.html" } };
+
+void startPortal(SimulatedThing* thing)
+{
+  thing->server.onNotFound([thing]() { thing->iotWebConf.handleNotFound(); });
+  thing->iotWebConf.init();
+  thing->step();
+}
+
+} // end anonymous namespace
+
+HOST_TEST(aQueryIsAnsweredWithTheApAddress)
+{
+  TestDnsResponder responder;
+  Packet query = makeQuery("connectivitycheck.gstatic.com", 1);
+  size_t length = responder.reply(query);
+  CHECK_EQ(query.size() + 16, length);
+
+  Packet reply = responder.lastReply(length);
+  CHECK_EQ(0x12, reply[0]);
+  CHECK_EQ(0x34, reply[1]);
+  // -- Response, authoritative, RD kept; one question, one answer.
+  CHECK_EQ(0x85, reply[2]);
+  CHECK_EQ(0x00, reply[3]);
+  CHECK_EQ(1, reply[5]);
+  CHECK_EQ(1, reply[7]);
+  CHECK(std::equal(query.begin() + 12, query.end(), reply.begin() + 12));
+  const uint8_t answer[] = {
+    0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 60, 0x00, 0x04,
+    192, 168, 4, 1 };
+  CHECK(std::equal(answer, answer + sizeof(answer), reply.begin() + query.size()));
+}
+
+HOST_TEST(otherQueriesGetAnEmptyReply)
+{
+  TestDnsResponder responder;
+  // -- AAAA and HTTPS records.
+  for (uint16_t type : { 28, 65 })
+  {
+    Packet query = makeQuery("captive.apple.com", type);
+    size_t length = responder.reply(query);
+    CHECK_EQ(query.size(), length);
+    Packet reply = responder.lastReply(length);
+    CHECK_EQ(0x85, reply[2]);
+    CHECK_EQ(0, reply[7]);
+  }
+}
+
+HOST_TEST(additionalRecordsAreDropped)
+{
+  TestDnsResponder responder;
+  Packet query = makeQuery("www.msftconnecttest.com", 1);
+  size_t questionEnd = query.size();
+  addEdns(&query);
+  size_t length = responder.reply(query);
+  CHECK_EQ(questionEnd + 16, length);
+  CHECK_EQ(0, responder.lastReply(length)[11]);
+}
+
+HOST_TEST(malformedQueriesAreDropped)
+{
+  TestDnsResponder responder;
+
+  Packet response = makeQuery("example.com", 1);
+  response[2] |= 0x80;
+  CHECK_EQ(0u, responder.reply(response));
+
+  Packet twoQuestions = makeQuery("example.com", 1);
+  twoQuestions[5] = 2;
+  CHECK_EQ(0u, responder.reply(twoQuestions));
+
+  Packet compressed = makeQuery("example.com", 1);
+  compressed[12] = 0xC0;
+  CHECK_EQ(0u, responder.reply(compressed));
+
+  Packet truncated = makeQuery("example.com", 1);
+  truncated.resize(truncated.size() - 3);
+  CHECK_EQ(0u, responder.reply(truncated));
+
+  // -- A label pointing beyond the end of the packet.
+  Packet overrun = makeQuery("example.com", 1);
+  overrun[12] = 60;
+  CHECK_EQ(0u, responder.reply(overrun));
+}
+
+HOST_TEST(probesAreRedirectedToThePortal)
+{
+  SimulatedThing thing;
+  startPortal(&thing);
+  CHECK_EQ(NotConfigured, thing.iotWebConf.getState());
+
+  for (const auto& probe : Probes)
+  {
+    const WebServer::Response& response =
+      thing.server.request(HTTP_GET, probe[1], WebServer::Args(), probe[0]);
+    CHECK_EQ(302, response.code);
+    CHECK(response.header("Location") == "http://192.168.4.1:80/");
+    CHECK_EQ(0u, response.content.length());
+  }
+}
+
+HOST_TEST(otherPagesOfOtherHostsAreRedirected)
+{
+  SimulatedThing thing;
+  startPortal(&thing);
+
+  const WebServer::Response& redirect =
+    thing.server.request(HTTP_GET, "/index.html", WebServer::Args(), "example.com");
+  CHECK_EQ(302, redirect.code);
+  CHECK(redirect.header("Location") == "http://192.168.4.1:80");
+
+  // -- Our own host names are not redirected.
+  const WebServer::Response& byIp =
+    thing.server.request(HTTP_GET, "/generate_204", WebServer::Args(), "192.168.4.1");
+  CHECK_EQ(404, byIp.code);
+  const WebServer::Response& byName =
+    thing.server.request(HTTP_GET, "/generate_204", WebServer::Args(), "testthing.local");
+  CHECK_EQ(404, byName.code);
+}
+
+HOST_TEST(benchmarkProbeLatency)
+{
+  SimulatedThing thing;
+  startPortal(&thing);
+  const int rounds = 20000;
+
+  TestDnsResponder responder;
+  Packet query = makeQuery("connectivitycheck.gstatic.com", 1);
+  addEdns(&query);
+  double start = host::wallMicros();
+  size_t replied = 0;
+  for (int i = 0; i < rounds; i++)
+  {
+    replied += responder.reply(query) > 0;
+  }
+  double dnsMicros = (host::wallMicros() - start) / rounds;
+  CHECK_EQ((size_t)rounds, replied);
+
+  start = host::wallMicros();
+  for (int i = 0; i < rounds; i++)
+  {
+    const auto& probe = Probes[i % (sizeof(Probes) / sizeof(Probes[0]))];
+    thing.server.request(HTTP_GET, probe[1], WebServer::Args(), probe[0]);
+  }
+  double probeMicros = (host::wallMicros() - start) / rounds;
+
+  start = host::wallMicros();
+  for (int i = 0; i < rounds; i++)
+  {
+    thing.server.request(HTTP_GET, "/index.html", WebServer::Args(), "example.com");
+  }
+  double otherMicros = (host::wallMicros() - start) / rounds;
+
+  printf("  DNS reply %.3f us, probe redirect %.3f us, other redirect %.3f us "
+    "(host, including the simulated web server)\n",
+    dnsMicros, probeMicros, otherMicros);
+}
@@ -0,0 +1,221 @@
+/**
+ * ChunkedUploadClient.h -- Client of the resumable (chunked) firmware
+ *   upload of the ESP32 HTTPUpdateServer, over an exchangeable transport.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef ChunkedUploadClient_h
+#define ChunkedUploadClient_h
+
+#include <WebServer.h>
+#include <vector>
+#include <zlib.h>
+
+namespace host
+{
+
+/**
+ * HTTP requests of the client. A request returns false, when no response
+ * arrived (the request or the response was lost).
+ */
+class Transport
+{
+public:
+  struct Reply
+  {
+    int code = 0;
+    String content;
+  };
+  virtual bool get(const char* uri, Reply* reply) = 0;
+  // -- POST, with the body sent as a file (multipart), when not empty.
+  virtual bool post(
+    const char* uri, const WebServer::Args& args,
+    const uint8_t* body, size_t length, Reply* reply) = 0;
+};
+
+/**
+ * Transport to the simulated WebServer, sending the credentials of this
+ * client.
+ */
+class SimulatedTransport : public Transport
+{
+public:
+  SimulatedTransport(WebServer* server, const char* user = "", const char* password = "") :
+    _server(server), _user(user), _password(password) { }
+
+  bool get(const char* uri, Reply* reply) override
+  {
+    this->_server->setClientCredentials(this->_user.c_str(), this->_password.c_str());
+    return this->toReply(this->_server->request(HTTP_GET, uri), reply);
+  }
+  bool post(
+    const char* uri, const WebServer::Args& args,
+    const uint8_t* body, size_t length, Reply* reply) override
+  {
+    return this->post(uri, args, body, length, reply, 0);
+  }
+  // -- The connection is lost after abortAfter bytes of the body (if not 0).
+  bool post(
+    const char* uri, const WebServer::Args& args,
+    const uint8_t* body, size_t length, Reply* reply, size_t abortAfter)
+  {
+    this->_server->setClientCredentials(this->_user.c_str(), this->_password.c_str());
+    if (length == 0)
+    {
+      return this->toReply(this->_server->request(HTTP_POST, uri, args), reply);
+    }
+    return this->toReply(this->_server->upload(uri, body, length, args, abortAfter), reply);
+  }
+
+private:
+  bool toReply(const WebServer::Response& response, Reply* reply)
+  {
+    reply->code = response.code;
+    reply->content = response.content;
+    return response.code != 0;
+  }
+  WebServer* _server;
+  String _user;
+  String _password;
+};
+
+/**
+ * Uploads an image in chunks, and resumes from the progress reported by
+ * the server after any failure.
+ */
+class ChunkedUploadClient
+{
+public:
+  ChunkedUploadClient(
+    Transport* transport, const char* path = "/firmware",
+    size_t chunkSize = 4096, int maxFailures = 1000) :
+    _transport(transport), _path(path), _chunkSize(chunkSize), _maxFailures(maxFailures) { }
+
+  /**
+   * Returns true, when the server accepted the complete image.
+   */
+  bool upload(const std::vector<uint8_t>& image, const String& sha256 = String())
+  {
+    WebServer::Args beginArgs = { { "size", String((unsigned long)image.size()) } };
+    if (sha256.length())
+    {
+      beginArgs.push_back({ "sha256", sha256 });
+    }
+    Transport::Reply reply;
+    while (!this->post("/begin", beginArgs, nullptr, 0, &reply) || (reply.code != 200))
+    {
+      if (!this->failed(reply))
+      {
+        return false;
+      }
+    }
+
+    size_t offset = 0;
+    while (offset < image.size())
+    {
+      size_t length = std::min(this->_chunkSize, image.size() - offset);
+      const uint8_t* chunk = image.data() + offset;
+      char crc[9];
+      snprintf(crc, sizeof(crc), "%08lx", crc32(0, chunk, length));
+      WebServer::Args chunkArgs = {
+        { "offset", String((unsigned long)offset) }, { "crc32", crc } };
+      if (this->post("/chunk", chunkArgs, chunk, length, &reply) && (reply.code == 200))
+      {
+        offset = field(reply.content, "received");
+        continue;
+      }
+      if (!this->failed(reply) || !this->resume(&offset))
+      {
+        return false;
+      }
+    }
+
+    while (!this->post("/end", WebServer::Args(), nullptr, 0, &reply) || (reply.code != 200))
+    {
+      if (!this->failed(reply))
+      {
+        return false;
+      }
+      // -- The response of a successful end might be lost: then there is
+      // no upload in progress any more, and no error.
+      Transport::Reply status;
+      if (this->get("/status", &status) && (field(status.content, "size") == 0))
+      {
+        return status.content.indexOf("\"error\"") < 0;
+      }
+    }
+    return true;
+  }
+
+  String lastError;
+  int requests = 0;
+  int failures = 0;
+  int resumes = 0;
+  size_t bytesSent = 0;
+
+  static size_t field(const String& json, const char* name)
+  {
+    String key = String("\"") + name + "\":";
+    int position = json.indexOf(key);
+    return position < 0 ? 0 : (size_t)json.substring(position + key.length()).toInt();
+  }
+
+private:
+  bool post(
+    const char* uri, const WebServer::Args& args,
+    const uint8_t* body, size_t length, Transport::Reply* reply)
+  {
+    this->requests++;
+    this->bytesSent += length;
+    *reply = Transport::Reply();
+    return this->_transport->post((this->_path + uri).c_str(), args, body, length, reply);
+  }
+  bool get(const char* uri, Transport::Reply* reply)
+  {
+    this->requests++;
+    *reply = Transport::Reply();
+    return this->_transport->get((this->_path + uri).c_str(), reply);
+  }
+
+  // -- Counts the failure, returns false, when the client gives up.
+  bool failed(const Transport::Reply& reply)
+  {
+    this->lastError = reply.code == 0 ? String("No response") : reply.content;
+    return (reply.code != 401) && (++this->failures < this->_maxFailures);
+  }
+
+  // -- Asks the server where to continue.
+  bool resume(size_t* offset)
+  {
+    this->resumes++;
+    Transport::Reply status;
+    while (!this->get("/status", &status) || (status.code != 200))
+    {
+      if (!this->failed(status))
+      {
+        return false;
+      }
+    }
+    if ((field(status.content, "size") == 0) || (status.content.indexOf("\"error\"") >= 0))
+    {
+      // -- The upload was cancelled or failed on the server.
+      this->lastError = status.content;
+      return false;
+    }
+    *offset = field(status.content, "received");
+    return true;
+  }
+
+  Transport* _transport;
+  String _path;
+  size_t _chunkSize;
+  int _maxFailures;
+};
+
+} // end namespace
+
+#endif
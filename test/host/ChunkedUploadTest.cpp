@@ -0,0 +1,332 @@
+/**
+ * ChunkedUploadTest.cpp -- Resumable (chunked) firmware upload of the ESP32
+ *   HTTPUpdateServer: the protocol, the CRC32, authentication, and complete
+ *   uploads over a simulated flaky transport.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "ChunkedUploadClient.h"
+#include "Firmware.h"
+#include <IotWebConfESP32HTTPUpdateServer.h>
+
+using host::ChunkedUploadClient;
+using host::SimulatedTransport;
+using host::Transport;
+
+namespace
+{
+
+// -- Exposes the checksum of the server.
+class TestUpdateServer : public HTTPUpdateServer
+{
+public:
+  static uint32_t crc32Of(const uint8_t* data, size_t length) { return _crc32(data, length); }
+};
+
+/**
+ * Loses requests and responses, cuts chunk uploads and corrupts chunks
+ * at random (seeded, so runs are repeatable).
+ */
+class FlakyTransport : public Transport
+{
+public:
+  FlakyTransport(SimulatedTransport* transport, int lossPercent, uint32_t seed = 1) :
+    _transport(transport), _lossPercent(lossPercent), _state(seed) { }
+
+  bool get(const char* uri, Reply* reply) override
+  {
+    switch (this->fault())
+    {
+      case LostRequest:
+        this->lostRequests++;
+        return false;
+      case LostResponse:
+        this->lostResponses++;
+        this->_transport->get(uri, reply);
+        *reply = Reply();
+        return false;
+      default:
+        return this->_transport->get(uri, reply);
+    }
+  }
+
+  bool post(
+    const char* uri, const WebServer::Args& args,
+    const uint8_t* body, size_t length, Reply* reply) override
+  {
+    switch (this->fault())
+    {
+      case LostRequest:
+        this->lostRequests++;
+        return false;
+      case LostResponse:
+        this->lostResponses++;
+        this->_transport->post(uri, args, body, length, reply);
+        *reply = Reply();
+        return false;
+      case CutUpload:
+        if (length > HTTP_UPLOAD_BUFLEN)
+        {
+          this->cutUploads++;
+          return this->_transport->post(uri, args, body, length, reply, length / 2);
+        }
+        break;
+      case CorruptBody:
+        if (length > 0)
+        {
+          this->corruptBodies++;
+          std::vector<uint8_t> corrupt(body, body + length);
+          corrupt[this->next() % length] ^= 0x10;
+          return this->_transport->post(uri, args, corrupt.data(), length, reply);
+        }
+        break;
+      default:
+        break;
+    }
+    return this->_transport->post(uri, args, body, length, reply);
+  }
+
+  int lostRequests = 0;
+  int lostResponses = 0;
+  int cutUploads = 0;
+  int corruptBodies = 0;
+
+private:
+  enum Fault { None, LostRequest, LostResponse, CutUpload, CorruptBody };
+  Fault fault()
+  {
+    if ((int)(this->next() % 100) >= this->_lossPercent)
+    {
+      return None;
+    }
+    return (Fault)(1 + this->next() % 4);
+  }
+  uint32_t next()
+  {
+    this->_state = this->_state * 1664525 + 1013904223;
+    return this->_state >> 8;
+  }
+  SimulatedTransport* _transport;
+  int _lossPercent;
+  uint32_t _state;
+};
+
+struct UpdateFixture
+{
+  UpdateFixture(const char* user = "", const char* password = "") :
+    transport(&this->server, user, password)
+  {
+    this->updateServer.setup(&this->server, "/firmware", user, password);
+  }
+  Transport::Reply post(
+    const char* uri, const WebServer::Args& args = WebServer::Args(),
+    const std::vector<uint8_t>& body = std::vector<uint8_t>())
+  {
+    Transport::Reply reply;
+    this->transport.post(uri, args, body.data(), body.size(), &reply);
+    return reply;
+  }
+  Transport::Reply sendChunk(const std::vector<uint8_t>& image, size_t offset, size_t length)
+  {
+    std::vector<uint8_t> chunk(image.begin() + offset, image.begin() + offset + length);
+    char crc[9];
+    snprintf(crc, sizeof(crc), "%08x", TestUpdateServer::crc32Of(chunk.data(), length));
+    return this->post("/firmware/chunk",
+      { { "offset", String((unsigned long)offset) }, { "crc32", crc } }, chunk);
+  }
+  WebServer server;
+  HTTPUpdateServer updateServer;
+  SimulatedTransport transport;
+};
+
+} // end anonymous namespace
+
+HOST_TEST(crc32MatchesZlib)
+{
+  const char* check = "123456789";
+  CHECK_EQ(0xCBF43926u, TestUpdateServer::crc32Of((const uint8_t*)check, 9));
+  CHECK_EQ(0u, TestUpdateServer::crc32Of(nullptr, 0));
+  std::vector<uint8_t> data = host::makeFirmware(5000, 7);
+  for (size_t length : { 1, 63, 64, 4096, 5000 })
+  {
+    CHECK_EQ((uint32_t)crc32(0, data.data(), length), TestUpdateServer::crc32Of(data.data(), length));
+  }
+}
+
+HOST_TEST(chunksAreWrittenInOrder)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(10000);
+
+  Transport::Reply reply = fixture.post("/firmware/begin", { { "size", "10000" } });
+  CHECK_EQ(200, reply.code);
+  CHECK(reply.content == "{\"size\":10000,\"received\":0}");
+
+  CHECK_EQ(200, fixture.sendChunk(image, 0, 4096).code);
+  // -- Gap: rejected, nothing is written.
+  reply = fixture.sendChunk(image, 8192, 1808);
+  CHECK_EQ(409, reply.code);
+  CHECK(reply.content.indexOf("Unexpected offset.") > 0);
+  // -- Repeated chunk (lost response): acknowledged, not written again.
+  reply = fixture.sendChunk(image, 0, 4096);
+  CHECK_EQ(200, reply.code);
+  CHECK(reply.content == "{\"size\":10000,\"received\":4096}");
+
+  reply = fixture.post("/firmware/end");
+  CHECK_EQ(409, reply.code);
+  CHECK(reply.content.indexOf("Image is not complete.") > 0);
+
+  CHECK_EQ(200, fixture.sendChunk(image, 4096, 4096).code);
+  CHECK_EQ(200, fixture.sendChunk(image, 8192, 1808).code);
+  reply = fixture.post("/firmware/end");
+  CHECK_EQ(200, reply.code);
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+  CHECK_EQ(1, ESP.restartCount);
+}
+
+HOST_TEST(badChunksAreRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(20000);
+  fixture.post("/firmware/begin", { { "size", "20000" } });
+
+  Transport::Reply reply = fixture.post("/firmware/chunk",
+    { { "offset", "0" }, { "crc32", "12345678" } },
+    std::vector<uint8_t>(image.begin(), image.begin() + 1000));
+  CHECK_EQ(400, reply.code);
+  CHECK(reply.content.indexOf("CRC32 mismatch.") > 0);
+
+  reply = fixture.post("/firmware/chunk", { { "offset", "0" }, { "crc32", "0" } });
+  CHECK_EQ(400, reply.code);
+  CHECK(reply.content.indexOf("Missing chunk data.") > 0);
+
+  reply = fixture.sendChunk(image, 0, IOTWEBCONF_UPDATE_CHUNK_SIZE + 1);
+  CHECK_EQ(400, reply.code);
+  CHECK(reply.content.indexOf("Chunk is too large.") > 0);
+
+  fixture.transport.get("/firmware/status", &reply);
+  CHECK(reply.content == "{\"size\":20000,\"received\":0}");
+  CHECK(Update.image.empty());
+}
+
+HOST_TEST(chunkOutsideUploadIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(1000);
+  Transport::Reply reply = fixture.sendChunk(image, 0, 1000);
+  CHECK_EQ(409, reply.code);
+  CHECK(reply.content.indexOf("No upload in progress.") > 0);
+  CHECK_EQ(400, fixture.post("/firmware/begin").code);
+}
+
+HOST_TEST(unauthenticatedRequestsDoNotDisturbTheUpload)
+{
+  UpdateFixture fixture("admin", "secret");
+  SimulatedTransport intruder(&fixture.server, "admin", "wrong");
+  std::vector<uint8_t> image = host::makeFirmware(10000);
+
+  CHECK_EQ(200, fixture.post("/firmware/begin", { { "size", "10000" } }).code);
+  CHECK_EQ(200, fixture.sendChunk(image, 0, 4096).code);
+
+  // -- Classic upload, a new begin, a chunk without data (that would
+  // write the last chunk again), and an end.
+  Transport::Reply reply;
+  std::vector<uint8_t> other = host::makeFirmware(3000, 99);
+  intruder.post("/firmware", WebServer::Args(), other.data(), other.size(), &reply);
+  CHECK_EQ(401, reply.code);
+  intruder.post("/firmware/begin", { { "size", "3000" } }, nullptr, 0, &reply);
+  CHECK_EQ(401, reply.code);
+  intruder.post("/firmware/chunk", { { "offset", "4096" } }, nullptr, 0, &reply);
+  CHECK_EQ(401, reply.code);
+  intruder.post("/firmware/end", WebServer::Args(), nullptr, 0, &reply);
+  CHECK_EQ(401, reply.code);
+  CHECK(Update.running);
+
+  CHECK_EQ(200, fixture.sendChunk(image, 4096, 4096).code);
+  CHECK_EQ(200, fixture.sendChunk(image, 8192, 1808).code);
+  CHECK_EQ(200, fixture.post("/firmware/end").code);
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+}
+
+HOST_TEST(clientUploadsOverReliableTransport)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(100000);
+  ChunkedUploadClient client(&fixture.transport);
+
+  CHECK(client.upload(image, host::sha256Hex(image)));
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+  // -- begin, 25 chunks, end.
+  CHECK_EQ(27, client.requests);
+  CHECK_EQ(0, client.failures);
+  CHECK_EQ(image.size(), client.bytesSent);
+}
+
+HOST_TEST(clientResumesOverFlakyTransport)
+{
+  for (int loss : { 10, 30, 50 })
+  {
+    Update.reset();
+    ESP.restartCount = 0;
+    UpdateFixture fixture;
+    FlakyTransport flaky(&fixture.transport, loss, loss);
+    std::vector<uint8_t> image = host::makeFirmware(300000);
+    ChunkedUploadClient client(&flaky);
+
+    bool uploaded = client.upload(image, host::sha256Hex(image));
+    CHECK(uploaded);
+    CHECK(Update.activated);
+    CHECK(Update.image == image);
+    CHECK_EQ(1, ESP.restartCount);
+    printf("  %d%% faults: %d requests, %d failures, %d resumes, %.2fx bytes sent "
+      "(lost %d requests, %d responses, cut %d chunks, corrupted %d)\n",
+      loss, client.requests, client.failures, client.resumes,
+      (double)client.bytesSent / image.size(),
+      flaky.lostRequests, flaky.lostResponses, flaky.cutUploads, flaky.corruptBodies);
+  }
+}
+
+HOST_TEST(clientUploadsGzipOverFlakyTransport)
+{
+  UpdateFixture fixture;
+  FlakyTransport flaky(&fixture.transport, 20, 5);
+  std::vector<uint8_t> image = host::makeFirmware(200000);
+  uLongf length = compressBound(image.size()) + 32;
+  std::vector<uint8_t> compressed(length);
+  // -- gzip format (windowBits 15 + 16).
+  z_stream stream = {};
+  deflateInit2(&stream, 9, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  stream.next_in = image.data();
+  stream.avail_in = image.size();
+  stream.next_out = compressed.data();
+  stream.avail_out = compressed.size();
+  deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  ChunkedUploadClient client(&flaky);
+  CHECK(client.upload(compressed, host::sha256Hex(compressed)));
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+}
+
+HOST_TEST(clientGivesUpWhenTheServerFails)
+{
+  UpdateFixture fixture;
+  Update.failWriteAt = 50000;
+  std::vector<uint8_t> image = host::makeFirmware(100000);
+  ChunkedUploadClient client(&fixture.transport);
+
+  CHECK(!client.upload(image));
+  CHECK(client.lastError.indexOf("Flash Write Failed") >= 0);
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
@@ -0,0 +1,71 @@
+/**
+ * Firmware.h -- Firmware images and digests for the update tests of the
+ *   IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef Firmware_h
+#define Firmware_h
+
+#include <Arduino.h>
+#include <mbedtls/sha256.h>
+#include <vector>
+
+namespace host
+{
+
+/**
+ * Pseudo random image, compressing about as well as a real firmware: half
+ * of the 64 byte blocks repeat an earlier block, the rest are noise.
+ */
+inline std::vector<uint8_t> makeFirmware(size_t size, uint32_t seed = 1)
+{
+  std::vector<uint8_t> image(size);
+  uint32_t state = seed;
+  auto next = [&state]() { state = state * 1664525 + 1013904223; return state >> 8; };
+  for (size_t block = 0; block < size; block += 64)
+  {
+    size_t length = std::min((size_t)64, size - block);
+    if ((block >= 4096) && (next() & 1))
+    {
+      size_t from = (next() % (block / 64)) * 64;
+      memcpy(&image[block], &image[from], length);
+      continue;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+      image[block + i] = next() & 0xFF;
+    }
+  }
+  return image;
+}
+
+inline String sha256Hex(const uint8_t* data, size_t length)
+{
+  mbedtls_sha256_context context;
+  unsigned char digest[32];
+  mbedtls_sha256_init(&context);
+  mbedtls_sha256_starts(&context, 0);
+  mbedtls_sha256_update(&context, data, length);
+  mbedtls_sha256_finish(&context, digest);
+  mbedtls_sha256_free(&context);
+  char hex[65];
+  for (int i = 0; i < 32; i++)
+  {
+    snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+  }
+  return String(hex);
+}
+
+inline String sha256Hex(const std::vector<uint8_t>& data)
+{
+  return sha256Hex(data.data(), data.size());
+}
+
+} // end namespace
+
+#endif
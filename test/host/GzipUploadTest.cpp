@@ -0,0 +1,195 @@
+/**
+ * GzipUploadTest.cpp -- Gzip compressed firmware upload: the image is
+ *   inflated on the fly by HTTPUpdateInflater into the simulated Update.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Firmware.h"
+#include <IotWebConfESP32HTTPUpdateServer.h>
+#include <zlib.h>
+
+namespace
+{
+
+// -- Compresses with zlib into the gzip format, optionally with a header
+// carrying every optional field (extra, name, comment, header CRC).
+std::vector<uint8_t> gzip(const std::vector<uint8_t>& data, bool fullHeader = false)
+{
+  z_stream stream = {};
+  deflateInit2(&stream, 9, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  gz_header header = {};
+  Bytef extra[] = { 'I', 'W', 3, 0, 1, 2, 3 };
+  char name[] = "firmware.bin";
+  char comment[] = "IotWebConf host test";
+  if (fullHeader)
+  {
+    header.extra = extra;
+    header.extra_len = sizeof(extra);
+    header.name = (Bytef*)name;
+    header.comment = (Bytef*)comment;
+    header.hcrc = 1;
+    deflateSetHeader(&stream, &header);
+  }
+  std::vector<uint8_t> result(deflateBound(&stream, data.size()) + 256);
+  stream.next_in = (Bytef*)data.data();
+  stream.avail_in = data.size();
+  stream.next_out = result.data();
+  stream.avail_out = result.size();
+  deflate(&stream, Z_FINISH);
+  result.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+struct UpdateFixture
+{
+  UpdateFixture() { this->updateServer.setup(&this->server, "/firmware"); }
+  const WebServer::Response& upload(
+    const std::vector<uint8_t>& image, const WebServer::Args& args = WebServer::Args())
+  {
+    return this->server.upload("/firmware", image.data(), image.size(), args);
+  }
+  WebServer server;
+  HTTPUpdateServer updateServer;
+};
+
+} // end anonymous namespace
+
+HOST_TEST(gzipImageIsInflated)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(300000);
+  std::vector<uint8_t> compressed = gzip(image);
+  CHECK(compressed.size() < image.size());
+  const WebServer::Response& response = fixture.upload(compressed);
+
+  CHECK_EQ(200, response.code);
+  String stats = String("Received ") + (unsigned long)compressed.size() +
+    " bytes, inflated to 300000 bytes";
+  CHECK(response.content.indexOf(stats) >= 0);
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+  CHECK_EQ(1, ESP.restartCount);
+}
+
+HOST_TEST(optionalHeaderFieldsAreSkipped)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(20000);
+  fixture.upload(gzip(image, true));
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+}
+
+HOST_TEST(digestIsOfTheUploadedFile)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(20000);
+  std::vector<uint8_t> compressed = gzip(image);
+
+  fixture.upload(compressed, { { "sha256", host::sha256Hex(image) } });
+  CHECK(!Update.activated);
+
+  Update.reset();
+  fixture.upload(compressed, { { "sha256", host::sha256Hex(compressed) } });
+  CHECK(Update.activated);
+}
+
+HOST_TEST(corruptDataIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> compressed = gzip(host::makeFirmware(100000));
+  // -- Reserved block type (11) in the first deflate block.
+  compressed[10] |= 0x06;
+  const WebServer::Response& response = fixture.upload(compressed);
+
+  CHECK(response.content == "Update error: Invalid gzip data.");
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(truncatedDataIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> compressed = gzip(host::makeFirmware(100000));
+  compressed.resize(compressed.size() / 2);
+  const WebServer::Response& response = fixture.upload(compressed);
+
+  CHECK(response.content == "Update error: Incomplete gzip data.");
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(sizeMismatchInTrailerIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> compressed = gzip(host::makeFirmware(100000));
+  compressed[compressed.size() - 4] ^= 1;
+  const WebServer::Response& response = fixture.upload(compressed);
+
+  CHECK(response.content == "Update error: Incomplete gzip data.");
+  CHECK(!Update.activated);
+}
+
+HOST_TEST(inflaterAcceptsAnyPieces)
+{
+  std::vector<uint8_t> image = host::makeFirmware(70000);
+  std::vector<uint8_t> compressed = gzip(image, true);
+  // -- Single bytes, and pieces crossing the header, block and trailer
+  // boundaries.
+  for (size_t piece : { (size_t)1, (size_t)7, (size_t)1436, (size_t)65536 })
+  {
+    Update.reset();
+    Update.begin();
+    HTTPUpdateInflater inflater;
+    CHECK(inflater.begin());
+    bool written = true;
+    for (size_t position = 0; position < compressed.size(); position += piece)
+    {
+      written &= inflater.write(
+        compressed.data() + position, std::min(piece, compressed.size() - position));
+    }
+    CHECK(written);
+    CHECK(inflater.isComplete());
+    CHECK_EQ(compressed.size(), inflater.getCompressedSize());
+    CHECK_EQ(image.size(), inflater.getInflatedSize());
+    CHECK(Update.image == image);
+    inflater.end();
+  }
+}
+
+HOST_TEST(benchmarkGzipUpload)
+{
+  // -- 1.2 MB image, as in the original report.
+  const size_t size = 1200 * 1024;
+  std::vector<uint8_t> image = host::makeFirmware(size);
+  std::vector<uint8_t> compressed = gzip(image);
+  UpdateFixture fixture;
+
+  Update.keepImage = false;
+  double start = host::wallMicros();
+  fixture.upload(image);
+  double plainMicros = host::wallMicros() - start;
+
+  Update.reset();
+  Update.keepImage = false;
+  start = host::wallMicros();
+  fixture.upload(compressed);
+  double gzipMicros = host::wallMicros() - start;
+  CHECK_EQ(size, Update.written);
+  CHECK(Update.activated);
+
+  // -- Transfer time over a weak AP link dominates on the device.
+  const double linkBytesPerSecond = 20 * 1024;
+  printf("  %u bytes compressed to %u bytes (%.0f%%)\n",
+    (unsigned)size, (unsigned)compressed.size(), 100.0 * compressed.size() / size);
+  printf("  upload %.1f MB/s plain, %.1f MB/s of inflated data with gzip (host)\n",
+    size / plainMicros, size / gzipMicros);
+  printf("  transfer at 20 kB/s: %.0f s plain, %.0f s with gzip\n",
+    size / linkBytesPerSecond, compressed.size() / linkBytesPerSecond);
+}
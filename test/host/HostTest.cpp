@@ -0,0 +1,87 @@
+/**
+ * HostTest.cpp -- Minimal test runner of the IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include <chrono>
+#include <vector>
+
+namespace host
+{
+
+namespace
+{
+struct Entry
+{
+  const char* name;
+  TestFunction function;
+};
+
+std::vector<Entry>& registry()
+{
+  static std::vector<Entry> entries;
+  return entries;
+}
+
+int failures = 0;
+} // end anonymous namespace
+
+TestCase::TestCase(const char* name, TestFunction function)
+{
+  registry().push_back({ name, function });
+}
+
+void fail(const char* file, int line, const char* message)
+{
+  failures++;
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message);
+}
+
+void skip(const char* reason)
+{
+  printf("SKIPPED: %s\n", reason);
+  fflush(stdout);
+  exit(SkipExitCode);
+}
+
+double wallMicros()
+{
+  return std::chrono::duration<double, std::micro>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int runTests(int argc, char** argv)
+{
+  int run = 0;
+  for (const Entry& entry : registry())
+  {
+    bool selected = (argc < 2);
+    for (int i = 1; i < argc; i++)
+    {
+      selected |= (strstr(entry.name, argv[i]) != nullptr);
+    }
+    if (!selected)
+    {
+      continue;
+    }
+    int failuresBefore = failures;
+    resetEnvironment();
+    entry.function();
+    printf("%s %s\n", failures == failuresBefore ? "PASS" : "FAIL", entry.name);
+    run++;
+  }
+  printf("%d test(s), %d failed check(s)\n", run, failures);
+  return (failures == 0) && (run > 0) ? 0 : 1;
+}
+
+} // end namespace
+
+int main(int argc, char** argv)
+{
+  return host::runTests(argc, argv);
+}
@@ -0,0 +1,63 @@
+/**
+ * HostTest.h -- Minimal test runner of the IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostTest_h
+#define HostTest_h
+
+#include <Arduino.h>
+#include <stdio.h>
+
+namespace host
+{
+
+typedef void (*TestFunction)();
+
+// -- Registers a test case, see HOST_TEST().
+struct TestCase
+{
+  TestCase(const char* name, TestFunction function);
+};
+
+// -- Records a failed check. The test goes on, so all failures are listed.
+void fail(const char* file, int line, const char* message);
+
+// -- Test cases are run in the order of definition. Selected test cases
+// can be run by passing (a part of) their names as arguments. Returns the
+// process exit code.
+int runTests(int argc, char** argv);
+
+// -- Skipped tests exit with this code (ctest SKIP_RETURN_CODE).
+const int SkipExitCode = 77;
+void skip(const char* reason);
+
+// -- Clock of the host (not the virtual one) for benchmarks.
+double wallMicros();
+
+} // end namespace
+
+#define HOST_TEST(name) \
+  static void name(); \
+  static host::TestCase name##Case(#name, name); \
+  static void name()
+
+#define CHECK(condition) \
+  do { if (!(condition)) host::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQ(expected, actual) \
+  do { \
+    auto e_ = (expected); auto a_ = (actual); \
+    if (!(e_ == a_)) \
+    { \
+      String m_ = String(#actual " == " #expected ", got: ") + String(a_) + \
+        ", expected: " + String(e_); \
+      host::fail(__FILE__, __LINE__, m_.c_str()); \
+    } \
+  } while (0)
+
+#endif
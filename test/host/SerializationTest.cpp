@@ -0,0 +1,239 @@
+/**
+ * SerializationTest.cpp -- Storing and loading a 100 parameter config tree
+ *   through the Serializer visitor, compared with the std::function
+ *   traversal it replaced.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Simulation.h"
+#include <EEPROM.h>
+#include <deque>
+#include <new>
+#include <stdlib.h>
+
+using namespace iotwebconf;
+using host::SimulatedThing;
+
+// -- Heap allocations are counted for the whole test binary.
+static unsigned long allocationCount = 0;
+void* operator new(size_t size)
+{
+  allocationCount++;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace
+{
+
+const int GroupCount = 10;
+const int ParametersPerGroup = 10;
+const int ValueLength = 16;
+
+/**
+ * Group with the traversal of the library before the Serializer: the
+ * std::function is passed by value to every item on every level.
+ */
+class LegacyGroup : public ParameterGroup
+{
+public:
+  LegacyGroup(const char* id) : ParameterGroup(id) { }
+  void legacyStore(std::function<void(SerializationData* serializationData)> doStore)
+  {
+    ConfigItem* current = this->_firstItem;
+    while (current != nullptr)
+    {
+      LegacyGroup* group = this->asLegacyGroup(current);
+      if (group != nullptr)
+      {
+        group->legacyStore(doStore);
+      }
+      else
+      {
+        current->storeValue(doStore);
+      }
+      current = this->getNextItemOf(current);
+    }
+  }
+  void store(Serializer& serializer) { this->storeValueTo(serializer); }
+  void addGroup(LegacyGroup* group)
+  {
+    this->addItem(group);
+    this->_groups[this->_groupCount++] = group;
+  }
+
+private:
+  // -- No RTTI, so the groups are remembered.
+  LegacyGroup* asLegacyGroup(ConfigItem* item)
+  {
+    for (int i = 0; i < this->_groupCount; i++)
+    {
+      if (this->_groups[i] == item)
+      {
+        return this->_groups[i];
+      }
+    }
+    return nullptr;
+  }
+  LegacyGroup* _groups[GroupCount];
+  int _groupCount = 0;
+};
+
+// -- 10 groups of 10 text parameters.
+struct Tree
+{
+  Tree() : root("root")
+  {
+    for (int g = 0; g < GroupCount; g++)
+    {
+      snprintf(this->groupIds[g], sizeof(this->groupIds[g]), "g%d", g);
+      this->groupStorage.emplace_back(this->groupIds[g]);
+      this->groups[g] = &this->groupStorage.back();
+      for (int p = 0; p < ParametersPerGroup; p++)
+      {
+        char* id = this->ids[g][p];
+        snprintf(id, sizeof(this->ids[g][p]), "g%dp%d", g, p);
+        this->parameters.emplace_back(id, id, this->values[g][p], ValueLength);
+        this->groups[g]->addItem(&this->parameters.back());
+      }
+      this->root.addGroup(this->groups[g]);
+    }
+    this->fill();
+  }
+  void fill()
+  {
+    for (int g = 0; g < GroupCount; g++)
+    {
+      for (int p = 0; p < ParametersPerGroup; p++)
+      {
+        snprintf(this->values[g][p], ValueLength, "value %d.%d", g, p);
+      }
+    }
+  }
+  LegacyGroup root;
+  LegacyGroup* groups[GroupCount];
+  std::deque<LegacyGroup> groupStorage;
+  std::deque<TextParameter> parameters;
+  char groupIds[GroupCount][4];
+  char ids[GroupCount][ParametersPerGroup][8];
+  char values[GroupCount][ParametersPerGroup][ValueLength];
+};
+
+// -- Sums the bytes passed, as a stand-in for the EEPROM.
+class ChecksumSerializer : public Serializer
+{
+public:
+  void serialize(SerializationData* serializationData) override
+  {
+    for (int i = 0; i < serializationData->length; i++)
+    {
+      this->sum += serializationData->data[i];
+    }
+    this->length += serializationData->length;
+  }
+  unsigned long sum = 0;
+  unsigned long length = 0;
+};
+
+} // end anonymous namespace
+
+HOST_TEST(visitorAndLegacyTraversalStoreTheSameBytes)
+{
+  Tree tree;
+  ChecksumSerializer visitor;
+  tree.root.store(visitor);
+  CHECK_EQ((unsigned long)(GroupCount * ParametersPerGroup * ValueLength), visitor.length);
+
+  ChecksumSerializer legacy;
+  tree.root.legacyStore(legacy.function());
+  CHECK_EQ(visitor.length, legacy.length);
+  CHECK_EQ(visitor.sum, legacy.sum);
+}
+
+HOST_TEST(configTreeRoundTripsThroughEeprom)
+{
+  Tree tree;
+  SimulatedThing thing;
+  thing.iotWebConf.addParameterGroup(&tree.root);
+  // -- Nothing is stored yet, so init() applies the (empty) defaults.
+  CHECK(!thing.iotWebConf.init());
+  CHECK(String(tree.values[3][7]) == "");
+  tree.fill();
+  thing.iotWebConf.saveConfig();
+
+  strcpy(tree.values[3][7], "changed");
+  strcpy(tree.values[9][9], "");
+  CHECK(thing.iotWebConf.loadConfig());
+  CHECK(String(tree.values[3][7]) == "value 3.7");
+  CHECK(String(tree.values[9][9]) == "value 9.9");
+}
+
+HOST_TEST(benchmarkHundredParameters)
+{
+  const int rounds = 20000;
+  Tree tree;
+  ChecksumSerializer serializer;
+  auto doStore = serializer.function();
+
+  // -- Same lambda shape as the one of the former saveConfig().
+  int start = 0;
+  auto legacyStore = [&](SerializationData* serializationData)
+  {
+    serializer.serialize(serializationData);
+    start += serializationData->length;
+  };
+
+  unsigned long allocations = allocationCount;
+  double wallStart = host::wallMicros();
+  for (int i = 0; i < rounds; i++)
+  {
+    tree.root.store(serializer);
+  }
+  double visitorMicros = (host::wallMicros() - wallStart) / rounds;
+  unsigned long visitorAllocations = allocationCount - allocations;
+
+  allocations = allocationCount;
+  wallStart = host::wallMicros();
+  for (int i = 0; i < rounds; i++)
+  {
+    tree.root.legacyStore(legacyStore);
+  }
+  double legacyMicros = (host::wallMicros() - wallStart) / rounds;
+  unsigned long legacyAllocations = allocationCount - allocations;
+
+  SimulatedThing thing;
+  thing.iotWebConf.addParameterGroup(&tree.root);
+  thing.iotWebConf.init();
+  allocations = allocationCount;
+  wallStart = host::wallMicros();
+  for (int i = 0; i < rounds / 10; i++)
+  {
+    thing.iotWebConf.loadConfig();
+  }
+  double loadMicros = (host::wallMicros() - wallStart) / (rounds / 10);
+  unsigned long loadAllocations = allocationCount - allocations;
+
+  printf("  %d parameters in %d groups, per traversal:\n", GroupCount * ParametersPerGroup, GroupCount);
+  printf("    Serializer visitor     %.2f us, %.1f allocations\n",
+    visitorMicros, (double)visitorAllocations / rounds);
+  printf("    std::function by value %.2f us, %.1f allocations\n",
+    legacyMicros, (double)legacyAllocations / rounds);
+  printf("    loadConfig() (EEPROM)  %.2f us, %.1f allocations\n",
+    loadMicros, (double)loadAllocations / (rounds / 10));
+  printf("    sizeof(std::function) %u, sizeof(Serializer&) %u\n",
+    (unsigned)sizeof(doStore), (unsigned)sizeof(void*));
+
+  // -- The visitor passes a reference: nothing is copied or allocated.
+  CHECK_EQ(0ul, visitorAllocations);
+}
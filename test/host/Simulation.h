@@ -0,0 +1,119 @@
+/**
+ * Simulation.h -- A Thing running IotWebConf in the simulated environment
+ *   of the host tests. doLoop() is driven on the virtual clock, so minutes
+ *   of timeouts pass in milliseconds.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef Simulation_h
+#define Simulation_h
+
+#include <IotWebConf.h>
+#include <vector>
+
+namespace host
+{
+
+class SimulatedThing
+{
+public:
+  SimulatedThing(const char* configVersion = "host1") :
+    iotWebConf("testThing", &this->dnsServer, &this->server, "initialPw", configVersion)
+  {
+  }
+
+  /**
+   * Stores a config in the EEPROM (as if it was set on the config portal
+   * before), so that the next init() finds a valid configuration.
+   */
+  void storeConfig(
+    const char* apPassword, const char* wifiSsid, const char* wifiPassword)
+  {
+    this->iotWebConf.init();
+    setValue(this->iotWebConf.getApPasswordParameter(), apPassword);
+    setValue(this->iotWebConf.getWifiSsidParameter(), wifiSsid);
+    setValue(this->iotWebConf.getWifiPasswordParameter(), wifiPassword);
+    this->iotWebConf.saveConfig();
+  }
+
+  static void setValue(iotwebconf::Parameter* parameter, const char* value)
+  {
+    strncpy(parameter->valueBuffer, value, parameter->getLength());
+    parameter->valueBuffer[parameter->getLength() - 1] = '\0';
+  }
+
+  /**
+   * Advances the virtual clock, and calls doLoop(). States entered are
+   * collected in states.
+   */
+  void step(unsigned long stepMs = 10)
+  {
+    advanceMillis(stepMs);
+    this->iotWebConf.doLoop();
+    this->loopCount++;
+    iotwebconf::NetworkState state = this->iotWebConf.getState();
+    if (this->states.empty() || (this->states.back() != state))
+    {
+      this->states.push_back(state);
+      this->stateTimesMs.push_back(millis());
+    }
+  }
+
+  void runFor(unsigned long durationMs, unsigned long stepMs = 10)
+  {
+    unsigned long start = millis();
+    while (millis() - start < durationMs)
+    {
+      this->step(stepMs);
+    }
+  }
+
+  /**
+   * Returns true, when the state was reached within the time limit.
+   */
+  bool runUntil(
+    iotwebconf::NetworkState state, unsigned long timeoutMs, unsigned long stepMs = 10)
+  {
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs)
+    {
+      this->step(stepMs);
+      if (this->iotWebConf.getState() == state)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // -- Compares the collected states with the expected ones.
+  bool statesWere(std::initializer_list<iotwebconf::NetworkState> expected)
+  {
+    return std::vector<iotwebconf::NetworkState>(expected) == this->states;
+  }
+
+  String describeStates()
+  {
+    String result;
+    for (size_t i = 0; i < this->states.size(); i++)
+    {
+      result += String(i == 0 ? "" : " ") + (int)this->states[i] + "@" + this->stateTimesMs[i];
+    }
+    return result;
+  }
+
+  DNSServer dnsServer;
+  WebServer server;
+  iotwebconf::IotWebConf iotWebConf;
+  std::vector<iotwebconf::NetworkState> states;
+  std::vector<unsigned long> stateTimesMs;
+  unsigned long loopCount = 0;
+};
+
+} // end namespace
+
+#endif
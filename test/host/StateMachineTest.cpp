@@ -0,0 +1,208 @@
+/**
+ * StateMachineTest.cpp -- Scenarios of the IotWebConf network state machine
+ *   on the virtual clock: AP timeout, connection failure fallback, lost
+ *   connection and MultipleWifiAddition failover.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Simulation.h"
+#include <IotWebConfMultipleWifi.h>
+
+using namespace iotwebconf;
+using host::SimulatedThing;
+
+HOST_TEST(notConfiguredStaysInApMode)
+{
+  SimulatedThing thing;
+  CHECK(!thing.iotWebConf.init());
+  thing.runFor(600000);
+
+  CHECK(thing.statesWere({ NotConfigured }));
+  CHECK(WiFi.apUp);
+  CHECK(WiFi.apSsid == "testThing");
+  CHECK(WiFi.apPassword == "initialPw");
+  CHECK(thing.dnsServer.running);
+  CHECK_EQ(0, WiFi.beginCount);
+}
+
+HOST_TEST(apTimeoutThenOnLine)
+{
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  CHECK(thing.iotWebConf.init());
+  thing.runFor(60000);
+
+  CHECK(thing.statesWere({ ApMode, Connecting, OnLine }));
+  // -- AP mode is entered by the first doLoop() at 11 ms. Default AP
+  // timeout is 30 seconds, connecting takes 2 seconds.
+  CHECK_EQ(11ul, thing.stateTimesMs[0]);
+  CHECK_EQ(30021ul, thing.stateTimesMs[1]);
+  CHECK_EQ(32021ul, thing.stateTimesMs[2]);
+  CHECK(!WiFi.apUp);
+  CHECK(WiFi.lastBeginSsid == "home");
+  CHECK(thing.server.begun());
+
+  const StateTransition* last = thing.iotWebConf.getStateTransition(0);
+  const StateTransition* previous = thing.iotWebConf.getStateTransition(1);
+  CHECK_EQ((int)CauseConnected, (int)last->cause);
+  CHECK_EQ((int)CauseTimeout, (int)previous->cause);
+}
+
+HOST_TEST(stationOnApDelaysTimeout)
+{
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.init();
+  thing.runFor(1000);
+  WiFi.stationNum = 1;
+  thing.runFor(120000);
+  CHECK(thing.statesWere({ ApMode }));
+
+  // -- Leaving the AP moves on immediately.
+  WiFi.stationNum = 0;
+  thing.step();
+  CHECK_EQ(Connecting, thing.iotWebConf.getState());
+  CHECK_EQ((int)CauseStationLeft, (int)thing.iotWebConf.getStateTransition(0)->cause);
+}
+
+HOST_TEST(connectionFailureFallsBackToAp)
+{
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.init();
+  // -- Two rounds of 30 s AP mode and 30 s connection attempt.
+  thing.runFor(125000);
+  CHECK(thing.statesWere({ ApMode, Connecting, ApMode, Connecting, ApMode }));
+  CHECK_EQ(2, WiFi.beginCount);
+  CHECK(WiFi.apUp);
+
+  // -- Network is back, the next round succeeds.
+  WiFi.addNetwork("home", "homePassword");
+  CHECK(thing.runUntil(OnLine, 60000));
+}
+
+HOST_TEST(wrongPasswordNeverConnects)
+{
+  WiFi.addNetwork("home", "otherPassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.init();
+  CHECK(!thing.runUntil(OnLine, 600000));
+  CHECK_EQ(10, WiFi.beginCount);
+}
+
+HOST_TEST(lostConnectionReconnects)
+{
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+  CHECK(thing.runUntil(OnLine, 5000));
+
+  WiFi.dropConnection();
+  thing.step();
+  CHECK_EQ(Connecting, thing.iotWebConf.getState());
+  CHECK_EQ((int)CauseWifiLost, (int)thing.iotWebConf.getStateTransition(0)->cause);
+
+  // -- WiFi keeps trying in the background, no AP fallback is needed.
+  thing.runFor(10000);
+  WiFi.setInRange("home", true);
+  CHECK(thing.runUntil(OnLine, 2010));
+  CHECK(thing.statesWere({ Connecting, OnLine, Connecting, OnLine }));
+}
+
+HOST_TEST(multipleWifiFailover)
+{
+  WiFi.addNetwork("backup", "backupPassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  ChainedWifiParameterGroup sets[] = {
+    ChainedWifiParameterGroup("wifi1"), ChainedWifiParameterGroup("wifi2") };
+  MultipleWifiAddition multipleWifi(&thing.iotWebConf, sets, 2);
+  multipleWifi.setNetworkScanEnabled(false);
+  multipleWifi.init();
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+  sets[0].setActive(true);
+  strcpy(sets[0].wifiSsid, "backup");
+  strcpy(sets[0].wifiPassword, "backupPassword");
+
+  // -- Primary network times out, the failure handler offers the backup.
+  CHECK(thing.runUntil(OnLine, 70000));
+  CHECK(thing.statesWere({ Connecting, OnLine }));
+  CHECK(WiFi.lastBeginSsid == "backup");
+  CHECK_EQ(2, WiFi.beginCount);
+  CHECK_EQ((int)CauseFailureHandler, (int)thing.iotWebConf.getStateTransition(1)->cause);
+}
+
+HOST_TEST(multipleWifiScanSelectsNetworkInRange)
+{
+  WiFi.addNetwork("backup", "backupPassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  ChainedWifiParameterGroup sets[] = { ChainedWifiParameterGroup("wifi1") };
+  MultipleWifiAddition multipleWifi(&thing.iotWebConf, sets, 1);
+  multipleWifi.init();
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+  sets[0].setActive(true);
+  strcpy(sets[0].wifiSsid, "backup");
+  strcpy(sets[0].wifiPassword, "backupPassword");
+
+  // -- Scan (1.5 s) finds the backup only, so it is tried first.
+  CHECK(thing.runUntil(OnLine, 10000));
+  CHECK_EQ(1, WiFi.scanCount);
+  CHECK_EQ(1, WiFi.beginCount);
+  CHECK(WiFi.lastBeginSsid == "backup");
+  CHECK_EQ(3511ul, thing.stateTimesMs.back());
+}
+
+HOST_TEST(noKnownNetworkInScanFallsBackToAp)
+{
+  WiFi.addNetwork("stranger", "whatever");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  ChainedWifiParameterGroup sets[] = { ChainedWifiParameterGroup("wifi1") };
+  MultipleWifiAddition multipleWifi(&thing.iotWebConf, sets, 1);
+  multipleWifi.init();
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+
+  CHECK(thing.runUntil(ApMode, 10000));
+  CHECK_EQ(0, WiFi.beginCount);
+  CHECK_EQ((int)CauseNoNetwork, (int)thing.iotWebConf.getStateTransition(0)->cause);
+}
+
+HOST_TEST(simulationIsFasterThanRealTime)
+{
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+
+  SimulatedThing thing;
+  thing.iotWebConf.init();
+  double start = host::wallMicros();
+  // -- One hour of failing connection rounds, doLoop() every 10 ms.
+  thing.runFor(3600000);
+  double elapsedMs = (host::wallMicros() - start) / 1000;
+  double speedup = 3600000 / (elapsedMs > 0 ? elapsedMs : 1);
+  printf("  %lu doLoop() calls, 1 hour simulated in %.1f ms (%.0fx real time)\n",
+    thing.loopCount, elapsedMs, speedup);
+  // -- A round is 30 s AP mode and 30 s connecting.
+  CHECK_EQ(120ul, (unsigned long)thing.states.size());
+  CHECK(speedup > 1000);
+}
@@ -0,0 +1,348 @@
+/**
+ * UpdateClientTest.cpp -- Pull based firmware update with HTTPUpdateClient:
+ *   version and manifest parsing, and downloads from a local Python HTTP
+ *   server (the test is skipped, when python3 is not available).
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Firmware.h"
+#include "Simulation.h"
+#include <IotWebConfHTTPUpdateClient.h>
+#include <fstream>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace iotwebconf;
+using host::SimulatedThing;
+
+namespace
+{
+
+// -- Exposes the manifest parser.
+class TestUpdateClient : public HTTPUpdateClient
+{
+public:
+  TestUpdateClient(const char* currentVersion = "1.0.0") : HTTPUpdateClient(currentVersion) { }
+  using HTTPUpdateClient::getManifestValue;
+};
+
+/**
+ * "python3 -m http.server" on a free port of localhost, serving the files
+ * of a temporary directory.
+ */
+class PythonHttpServer
+{
+public:
+  PythonHttpServer()
+  {
+    char directory[] = "/tmp/iotwebconf-XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+      return;
+    }
+    this->directory = directory;
+    int output[2];
+    if (pipe(output) != 0)
+    {
+      return;
+    }
+    this->_pid = fork();
+    if (this->_pid == 0)
+    {
+      // -- Child: the port is printed once the server is listening.
+      dup2(output[1], STDOUT_FILENO);
+      close(output[0]);
+      if (chdir(directory) != 0)
+      {
+        _exit(1);
+      }
+      execlp("python3", "python3", "-u", "-c",
+        "import http.server\n"
+        "class Handler(http.server.SimpleHTTPRequestHandler):\n"
+        "  def log_message(self, *args): pass\n"
+        "server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Handler)\n"
+        "print(server.server_address[1])\n"
+        "server.serve_forever()\n",
+        (char*)nullptr);
+      _exit(127);
+    }
+    close(output[1]);
+    FILE* in = fdopen(output[0], "r");
+    unsigned port = 0;
+    if ((in != nullptr) && (fscanf(in, "%u", &port) == 1))
+    {
+      this->port = port;
+    }
+    if (in != nullptr)
+    {
+      fclose(in);
+    }
+    if (this->port == 0)
+    {
+      // -- The test is skipped, clean up now.
+      this->stop();
+      this->removeDirectory();
+    }
+  }
+  ~PythonHttpServer()
+  {
+    this->stop();
+    this->removeDirectory();
+  }
+  void stop()
+  {
+    if (this->_pid > 0)
+    {
+      kill(this->_pid, SIGTERM);
+      waitpid(this->_pid, nullptr, 0);
+      this->_pid = -1;
+    }
+  }
+  bool running() { return this->port != 0; }
+  String url(const char* file) { return String("http://127.0.0.1:") + this->port + "/" + file; }
+  void writeFile(const char* name, const uint8_t* data, size_t length)
+  {
+    std::ofstream out((this->directory + "/" + name).c_str(), std::ios::binary);
+    out.write((const char*)data, length);
+  }
+  void writeFile(const char* name, const String& text)
+  {
+    this->writeFile(name, (const uint8_t*)text.c_str(), text.length());
+  }
+  void publish(
+    const char* version, const std::vector<uint8_t>& image,
+    size_t announcedSize = 0, const String& digest = String())
+  {
+    this->writeFile("firmware.bin", image.data(), image.size());
+    this->writeFile("manifest.txt",
+      String("version=") + version + "\r\n" +
+      "size=" + (unsigned long)(announcedSize ? announcedSize : image.size()) + "\r\n" +
+      "sha256=" + (digest.length() ? digest : host::sha256Hex(image)) + "\r\n" +
+      "url=" + this->url("firmware.bin") + "\r\n");
+  }
+
+  String directory;
+  unsigned port = 0;
+
+private:
+  void removeDirectory()
+  {
+    if (this->directory.length())
+    {
+      for (const char* file : { "/firmware.bin", "/manifest.txt" })
+      {
+        unlink((this->directory + file).c_str());
+      }
+      rmdir(this->directory.c_str());
+      this->directory = String();
+    }
+  }
+  pid_t _pid = -1;
+};
+
+/**
+ * Calls doLoop() until the condition holds, or the time limit (real time)
+ * passes. The virtual clock goes along with the real one, so the timeouts
+ * of the client hold. Returns the condition.
+ */
+bool runClient(
+  HTTPUpdateClient* client, std::function<bool()> condition, unsigned long limitMs = 5000)
+{
+  double start = host::wallMicros();
+  while (!condition())
+  {
+    if (host::wallMicros() - start > limitMs * 1000.0)
+    {
+      return false;
+    }
+    client->doLoop();
+    usleep(50);
+    host::advanceMicros(50);
+  }
+  return true;
+}
+
+bool restarted() { return ESP.restartCount > 0; }
+
+} // end anonymous namespace
+
+HOST_TEST(versionsAreComparedByParts)
+{
+  CHECK(HTTPUpdateClient::compareVersions("1.2.0", "1.10.0") < 0);
+  CHECK(HTTPUpdateClient::compareVersions("1.10.0", "1.9.9") > 0);
+  CHECK(HTTPUpdateClient::compareVersions("2", "1.99") > 0);
+  CHECK_EQ(0, HTTPUpdateClient::compareVersions("1.2.3", "1.2.3"));
+  CHECK_EQ(0, HTTPUpdateClient::compareVersions("1.2", "1.2.0"));
+  CHECK(HTTPUpdateClient::compareVersions("1.2", "1.2.1") < 0);
+  CHECK(HTTPUpdateClient::compareVersions("1.2a", "1.2b") < 0);
+  CHECK(HTTPUpdateClient::compareVersions("", "0.1") < 0);
+}
+
+HOST_TEST(manifestValuesAreFound)
+{
+  String manifest = "version=1.2.0\r\n  size=1234  \n\nurlx=no\nurl=http://h/f.bin\nsha256=ab";
+  CHECK(TestUpdateClient::getManifestValue(manifest, "version") == "1.2.0");
+  CHECK(TestUpdateClient::getManifestValue(manifest, "size") == "1234");
+  CHECK(TestUpdateClient::getManifestValue(manifest, "url") == "http://h/f.bin");
+  // -- Last line has no line end.
+  CHECK(TestUpdateClient::getManifestValue(manifest, "sha256") == "ab");
+  CHECK(TestUpdateClient::getManifestValue(manifest, "missing") == "");
+  CHECK(TestUpdateClient::getManifestValue("", "version") == "");
+}
+
+HOST_TEST(newerVersionIsDownloaded)
+{
+  PythonHttpServer server;
+  if (!server.running())
+  {
+    host::skip("python3 is not available");
+  }
+  std::vector<uint8_t> image = host::makeFirmware(300000);
+  server.publish("1.1.0", image);
+
+  HTTPUpdateClient client("1.0.0");
+  String manifestUrl = server.url("manifest.txt");
+  client.setManifestUrl(manifestUrl.c_str());
+  String offered;
+  client.setUpdateStartingCallback([&](const char* version)
+  {
+    offered = version;
+    return true;
+  });
+  double start = host::wallMicros();
+  CHECK(runClient(&client, restarted));
+  double elapsedMs = (host::wallMicros() - start) / 1000;
+
+  CHECK(offered == "1.1.0");
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+  CHECK(client.getLastError() == "");
+  printf("  %u bytes downloaded from python3 http.server in %.0f ms\n",
+    (unsigned)image.size(), elapsedMs);
+}
+
+HOST_TEST(sameVersionIsNotDownloaded)
+{
+  PythonHttpServer server;
+  if (!server.running())
+  {
+    host::skip("python3 is not available");
+  }
+  server.publish("1.0.0", host::makeFirmware(10000));
+
+  HTTPUpdateClient client("1.0.0");
+  String manifestUrl = server.url("manifest.txt");
+  client.setManifestUrl(manifestUrl.c_str());
+  bool offered = false;
+  client.setUpdateStartingCallback([&](const char*) { return offered = true; });
+  CHECK(!runClient(&client, restarted, 300));
+  CHECK(!offered);
+  CHECK(Update.calls.empty());
+  CHECK(client.getLastError() == "");
+}
+
+HOST_TEST(declinedUpdateIsOfferedAgain)
+{
+  PythonHttpServer server;
+  if (!server.running())
+  {
+    host::skip("python3 is not available");
+  }
+  server.publish("1.1.0", host::makeFirmware(10000));
+
+  HTTPUpdateClient client("1.0.0");
+  String manifestUrl = server.url("manifest.txt");
+  client.setManifestUrl(manifestUrl.c_str());
+  client.setCheckInterval(60000);
+  int offers = 0;
+  client.setUpdateStartingCallback([&](const char*) { offers++; return false; });
+  CHECK(runClient(&client, [&]() { return offers == 1; }));
+
+  // -- Next check is after the interval.
+  CHECK(!runClient(&client, [&]() { return offers == 2; }, 200));
+  host::advanceMillis(60000);
+  CHECK(runClient(&client, [&]() { return offers == 2; }));
+  CHECK(Update.calls.empty());
+}
+
+HOST_TEST(badDownloadsAreRejected)
+{
+  PythonHttpServer server;
+  if (!server.running())
+  {
+    host::skip("python3 is not available");
+  }
+  std::vector<uint8_t> image = host::makeFirmware(50000);
+  HTTPUpdateClient client("1.0.0");
+  String manifestUrl = server.url("manifest.txt");
+  client.setManifestUrl(manifestUrl.c_str());
+  auto failed = [&]() { return client.getLastError().length() > 0; };
+
+  // -- Manifest does not exist.
+  CHECK(runClient(&client, failed));
+  CHECK(client.getLastError() == "Manifest download failed: 404");
+
+  server.publish("1.1.0", image, 0, host::sha256Hex(host::makeFirmware(50000, 2)));
+  client.checkNow();
+  CHECK(runClient(&client, [&]() { return client.getLastError() != "Manifest download failed: 404"; }));
+  CHECK(client.getLastError() == "SHA-256 digest mismatch.");
+  CHECK(!Update.activated);
+
+  server.publish("1.1.0", image, 40000);
+  client.checkNow();
+  CHECK(runClient(&client, [&]() { return client.getLastError() != "SHA-256 digest mismatch."; }));
+  CHECK(client.getLastError() == "Firmware size does not match the manifest.");
+
+  server.writeFile("manifest.txt", "version=1.1.0\n");
+  client.checkNow();
+  CHECK(runClient(&client, [&]() { return client.getLastError() != "Firmware size does not match the manifest."; }));
+  CHECK(client.getLastError() == "Invalid manifest.");
+
+  server.stop();
+  client.checkNow();
+  CHECK(runClient(&client, [&]() { return client.getLastError() != "Invalid manifest."; }));
+  CHECK(client.getLastError() == "Manifest server not available.");
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(updateRunsFromDoLoopWhenOnLine)
+{
+  PythonHttpServer server;
+  if (!server.running())
+  {
+    host::skip("python3 is not available");
+  }
+  std::vector<uint8_t> image = host::makeFirmware(100000);
+  server.publish("1.1.0", image);
+
+  WiFi.addNetwork("home", "homePassword");
+  SimulatedThing().storeConfig("apPassword", "home", "homePassword");
+  SimulatedThing thing;
+  HTTPUpdateClient client("1.0.0");
+  String manifestUrl = server.url("manifest.txt");
+  client.setManifestUrl(manifestUrl.c_str());
+  thing.iotWebConf.setupUpdateClient([&]() { client.doLoop(); });
+  thing.iotWebConf.skipApStartup();
+  thing.iotWebConf.init();
+
+  // -- Nothing is requested while connecting.
+  thing.runFor(1000);
+  CHECK(Update.calls.empty());
+  CHECK(thing.runUntil(OnLine, 5000));
+  double start = host::wallMicros();
+  while (!restarted() && (host::wallMicros() - start < 5000000))
+  {
+    usleep(50);
+    thing.step(0);
+    host::advanceMicros(50);
+  }
+  CHECK(restarted());
+  CHECK(Update.image == image);
+}
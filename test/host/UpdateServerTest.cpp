@@ -0,0 +1,191 @@
+/**
+ * UpdateServerTest.cpp -- Firmware upload through the ESP32 HTTPUpdateServer
+ *   into the simulated Update: SHA-256 verification, authentication, and
+ *   the upload throughput on the host.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include "HostTest.h"
+#include "Firmware.h"
+#include <IotWebConfESP32HTTPUpdateServer.h>
+
+namespace
+{
+
+struct UpdateFixture
+{
+  UpdateFixture(const char* user = "", const char* password = "")
+  {
+    this->updateServer.setup(&this->server, "/firmware", user, password);
+  }
+  const WebServer::Response& upload(
+    const std::vector<uint8_t>& image, const WebServer::Args& args = WebServer::Args())
+  {
+    return this->server.upload("/firmware", image.data(), image.size(), args);
+  }
+  WebServer server;
+  HTTPUpdateServer updateServer;
+};
+
+// -- Time on the virtual clock spent with Serial output during an upload,
+// at 1 us per byte.
+uint64_t serialMicrosOfUpload(size_t size)
+{
+  Update.reset();
+  Update.keepImage = false;
+  HTTPUpdateServer updateServer(true);
+  WebServer server;
+  updateServer.setup(&server, "/firmware", "", "");
+  std::vector<uint8_t> image = host::makeFirmware(size);
+  host::setSerialMicrosPerByte(1);
+  uint64_t start = micros();
+  server.upload("/firmware", image.data(), image.size());
+  host::setSerialMicrosPerByte(0);
+  // -- The success handler waits 100 ms before the restart.
+  return micros() - start - 100000;
+}
+
+double megabytesPerSecond(size_t size, double micros)
+{
+  return micros > 0 ? size / micros : 0;
+}
+
+} // end anonymous namespace
+
+HOST_TEST(uploadIsActivated)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(100000);
+  const WebServer::Response& response = fixture.upload(image);
+
+  CHECK_EQ(200, response.code);
+  CHECK(response.content.indexOf("Update Success!") >= 0);
+  CHECK(response.content.indexOf("Received 100000 bytes") >= 0);
+  CHECK(Update.activated);
+  CHECK(Update.image == image);
+  CHECK_EQ(1, ESP.restartCount);
+}
+
+HOST_TEST(matchingDigestIsAccepted)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(50000);
+  // -- The digest is not case sensitive.
+  String digest = host::sha256Hex(image);
+  digest.toUpperCase();
+  const WebServer::Response& response = fixture.upload(image, { { "sha256", digest } });
+
+  CHECK_EQ(200, response.code);
+  CHECK(response.content.indexOf("Update Success!") >= 0);
+  CHECK(Update.activated);
+  CHECK_EQ(1, ESP.restartCount);
+}
+
+HOST_TEST(mismatchingDigestIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(50000);
+  String digest = host::sha256Hex(image);
+  image[25000] ^= 1;
+  const WebServer::Response& response = fixture.upload(image, { { "sha256", digest } });
+
+  CHECK_EQ(200, response.code);
+  CHECK(response.content == "Update error: SHA-256 digest mismatch.");
+  CHECK(!Update.activated);
+  CHECK(Update.calls.back() == "abort");
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(invalidDigestIsRejected)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(5000);
+  const WebServer::Response& response = fixture.upload(image, { { "sha256", "abc" } });
+
+  CHECK(response.content == "Update error: Invalid SHA-256 digest.");
+  CHECK(Update.calls.empty());
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(flashErrorIsReported)
+{
+  UpdateFixture fixture;
+  Update.failWriteAt = 20000;
+  std::vector<uint8_t> image = host::makeFirmware(50000);
+  const WebServer::Response& response = fixture.upload(image);
+
+  CHECK(response.content.startsWith("Update error: Flash Write Failed"));
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(unauthenticatedUploadIsRefused)
+{
+  UpdateFixture fixture("admin", "secret");
+  fixture.server.setClientCredentials("admin", "wrong");
+  std::vector<uint8_t> image = host::makeFirmware(5000);
+  const WebServer::Response& response = fixture.upload(image);
+
+  CHECK_EQ(401, response.code);
+  CHECK(Update.calls.empty());
+
+  fixture.server.setClientCredentials("admin", "secret");
+  CHECK_EQ(200, fixture.upload(image).code);
+  CHECK(Update.activated);
+}
+
+HOST_TEST(abortedUploadIsDiscarded)
+{
+  UpdateFixture fixture;
+  std::vector<uint8_t> image = host::makeFirmware(50000);
+  const WebServer::Response& response =
+    fixture.server.upload("/firmware", image.data(), image.size(), WebServer::Args(), 30000);
+
+  CHECK_EQ(0, response.code);
+  CHECK(!Update.running);
+  CHECK(!Update.activated);
+  CHECK_EQ(0, ESP.restartCount);
+}
+
+HOST_TEST(noSerialOutputPerChunk)
+{
+  // -- Serial output must not grow with the image (no progress dots). Only
+  // the digits of the size in the statistics line differ.
+  uint64_t small = serialMicrosOfUpload(10000);
+  uint64_t large = serialMicrosOfUpload(1000000);
+  printf("  Serial output: %lu bytes (10 kB image), %lu bytes (1 MB image)\n",
+    (unsigned long)small, (unsigned long)large);
+  CHECK(small > 0);
+  CHECK(large - small <= 2);
+}
+
+HOST_TEST(benchmarkUploadThroughput)
+{
+  const size_t size = 4 * 1024 * 1024;
+  std::vector<uint8_t> image = host::makeFirmware(size);
+  String digest = host::sha256Hex(image);
+
+  UpdateFixture fixture;
+  Update.keepImage = false;
+  double start = host::wallMicros();
+  CHECK_EQ(200, fixture.upload(image).code);
+  double plainMicros = host::wallMicros() - start;
+
+  Update.reset();
+  Update.keepImage = false;
+  start = host::wallMicros();
+  const WebServer::Response& response = fixture.upload(image, { { "sha256", digest } });
+  double digestMicros = host::wallMicros() - start;
+  CHECK(response.content.indexOf("Update Success!") >= 0);
+  CHECK_EQ(size, Update.written);
+
+  // -- The image is hashed in both cases, the digest is only compared.
+  printf("  %u kB in %u byte pieces: %.1f MB/s, %.1f MB/s with expected SHA-256 "
+    "(host, Update sink without flash)\n",
+    (unsigned)(size / 1024), (unsigned)HTTP_UPLOAD_BUFLEN,
+    megabytesPerSecond(size, plainMicros), megabytesPerSecond(size, digestMicros));
+}
@@ -0,0 +1,161 @@
+/**
+ * Arduino.cpp -- Host stand-in of the Arduino core for the IotWebConf host
+ *   tests: virtual clock, pins, Serial and the small ESP32 libraries.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESPmDNS.h>
+#include <map>
+
+namespace
+{
+const uint64_t ClockStartMicros = 1000;
+uint64_t clockMicros = ClockStartMicros;
+uint32_t microsPerCall = 0;
+std::map<int, int> pinLevels;
+bool serialEcho = getenv("IOTWEBCONF_HOST_SERIAL") != nullptr;
+uint32_t serialMicrosPerByte = 0;
+} // end anonymous namespace
+
+HardwareSerial Serial;
+EspClass ESP;
+EEPROMClass EEPROM;
+MDNSResponder MDNS;
+
+unsigned long millis()
+{
+  return (unsigned long)(clockMicros / 1000);
+}
+
+unsigned long micros()
+{
+  clockMicros += microsPerCall;
+  return (unsigned long)clockMicros;
+}
+
+void delay(unsigned long ms)
+{
+  clockMicros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  clockMicros += us;
+}
+
+void yield()
+{
+}
+
+void pinMode(int pin, int mode)
+{
+}
+
+int digitalRead(int pin)
+{
+  return host::getPinLevel(pin);
+}
+
+void digitalWrite(int pin, int value)
+{
+  pinLevels[pin] = value;
+}
+
+long random(long max)
+{
+  return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max)
+{
+  return min < max ? min + random(max - min) : min;
+}
+
+namespace host
+{
+
+void resetClock()
+{
+  clockMicros = ClockStartMicros;
+  microsPerCall = 0;
+  serialMicrosPerByte = 0;
+}
+
+void advanceMicros(uint64_t us)
+{
+  clockMicros += us;
+}
+
+void advanceMillis(unsigned long ms)
+{
+  clockMicros += (uint64_t)ms * 1000;
+}
+
+void setMicrosPerCall(uint32_t us)
+{
+  microsPerCall = us;
+}
+
+void setPinLevel(int pin, int level)
+{
+  pinLevels[pin] = level;
+}
+
+int getPinLevel(int pin)
+{
+  auto level = pinLevels.find(pin);
+  return level == pinLevels.end() ? HIGH : level->second;
+}
+
+void setSerialEcho(bool echo)
+{
+  serialEcho = echo;
+}
+
+void setSerialMicrosPerByte(uint32_t us)
+{
+  serialMicrosPerByte = us;
+}
+
+} // end namespace
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return this->write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+  if (serialEcho)
+  {
+    fwrite(buffer, 1, size, stdout);
+  }
+  clockMicros += (uint64_t)serialMicrosPerByte * size;
+  return size;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size)
+{
+  if ((offset * 4 + size) > sizeof(this->rtcMemory))
+  {
+    return false;
+  }
+  memcpy(data, this->rtcMemory + offset, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size)
+{
+  if ((offset * 4 + size) > sizeof(this->rtcMemory))
+  {
+    return false;
+  }
+  memcpy(this->rtcMemory + offset, data, size);
+  return true;
+}
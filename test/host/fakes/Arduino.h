@@ -0,0 +1,304 @@
+/**
+ * Arduino.h -- Host (Linux) stand-in of the Arduino core for the IotWebConf
+ *   host tests. Only what IotWebConf uses is provided.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostArduino_h
+#define HostArduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(s) (s)
+typedef char __FlashStringHelper;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+#define strncpy_P strncpy
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+long random(long max);
+long random(long min, long max);
+
+/**
+ * Controls of the simulated environment.
+ */
+namespace host
+{
+// -- Virtual clock. It starts at 1 ms, as zero is "not yet" in many places.
+void resetClock();
+// -- Clock, WiFi, EEPROM (erased), Update and ESP are set back to their
+// initial state. Called before each test case.
+void resetEnvironment();
+void advanceMicros(uint64_t us);
+void advanceMillis(unsigned long ms);
+// -- Every micros() call moves the clock with this amount (default 0), so
+// consecutive timestamps of a busy code path are distinct.
+void setMicrosPerCall(uint32_t us);
+// -- Level read from an input pin (default HIGH, as with a pull-up).
+void setPinLevel(int pin, int level);
+int getPinLevel(int pin);
+// -- Serial output is dropped, unless echo is turned on (or the
+// IOTWEBCONF_HOST_SERIAL environment variable is set).
+void setSerialEcho(bool echo);
+// -- Serial output moves the clock with this amount per byte (default 0),
+// e.g. 87 us at 115200 baud.
+void setSerialMicrosPerByte(uint32_t us);
+} // end namespace
+
+class String
+{
+public:
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& c) : s(c) {}
+  String(char c) : s(1, c) {}
+  String(unsigned char v, int base = 10) : s(toBase(v, base)) {}
+  String(int v, int base = 10) : s(base == 10 ? std::to_string(v) : toBase(v, base)) {}
+  String(unsigned v, int base = 10) : s(toBase(v, base)) {}
+  String(long v, int base = 10) : s(base == 10 ? std::to_string(v) : toBase(v, base)) {}
+  String(unsigned long v, int base = 10) : s(toBase(v, base)) {}
+  String(long long v) : s(std::to_string(v)) {}
+  String(unsigned long long v) : s(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) : s(toFixed(v, decimals)) {}
+  String(double v, unsigned int decimals = 2) : s(toFixed(v, decimals)) {}
+
+  size_t length() const { return s.size(); }
+  const char* c_str() const { return s.c_str(); }
+  char charAt(size_t i) const { return i < s.size() ? s[i] : 0; }
+  char operator[](size_t i) const { return charAt(i); }
+  void replace(const String& a, const String& b)
+  {
+    if (a.s.empty()) return;
+    size_t p = 0;
+    while ((p = s.find(a.s, p)) != std::string::npos) { s.replace(p, a.s.size(), b.s); p += b.s.size(); }
+  }
+  void toLowerCase() { for (char& c : s) c = tolower((unsigned char)c); }
+  void toUpperCase() { for (char& c : s) c = toupper((unsigned char)c); }
+  bool startsWith(const String& o) const { return s.rfind(o.s, 0) == 0; }
+  bool endsWith(const String& o) const
+    { return s.size() >= o.s.size() && s.compare(s.size() - o.s.size(), o.s.size(), o.s) == 0; }
+  bool equals(const String& o) const { return s == o.s; }
+  bool equals(const char* o) const { return s == (o ? o : ""); }
+  bool equalsIgnoreCase(const String& o) const { return strcasecmp(s.c_str(), o.s.c_str()) == 0; }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return equals(o); }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator!=(const char* o) const { return !equals(o); }
+  bool operator<(const String& o) const { return s < o.s; }
+  String& operator+=(const String& o) { s += o.s; return *this; }
+  String& operator+=(const char* o) { if (o) s += o; return *this; }
+  String& operator+=(char o) { s += o; return *this; }
+  String& operator+=(unsigned char o) { s += std::to_string(o); return *this; }
+  String& operator+=(int o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned o) { s += std::to_string(o); return *this; }
+  String& operator+=(long o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned long o) { s += std::to_string(o); return *this; }
+  String& operator+=(long long o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned long long o) { s += std::to_string(o); return *this; }
+  String& operator+=(float o) { s += toFixed(o, 2); return *this; }
+  String& operator+=(double o) { s += toFixed(o, 2); return *this; }
+  bool concat(const char* c, unsigned int len) { s.append(c, len); return true; }
+  bool concat(const String& o) { s += o.s; return true; }
+  void toCharArray(char* b, unsigned len) const
+    { if (len) { strncpy(b, s.c_str(), len); b[len - 1] = '\0'; } }
+  void getBytes(unsigned char* b, unsigned len) const { toCharArray((char*)b, len); }
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return atof(s.c_str()); }
+  double toDouble() const { return atof(s.c_str()); }
+  bool reserve(size_t n) { s.reserve(n); return true; }
+  int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+  int indexOf(const String& o, unsigned int from = 0) const { return found(s.find(o.s, from)); }
+  int lastIndexOf(char c) const { return found(s.rfind(c)); }
+  void trim()
+  {
+    size_t a = s.find_first_not_of(" \t\r\n");
+    size_t b = s.find_last_not_of(" \t\r\n");
+    s = (a == std::string::npos) ? std::string() : s.substr(a, b - a + 1);
+  }
+  String substring(size_t a) const { return a < s.size() ? String(s.substr(a)) : String(); }
+  String substring(size_t a, size_t b) const
+  {
+    if (b > s.size()) b = s.size();
+    return a < b ? String(s.substr(a, b - a)) : String();
+  }
+  void remove(size_t index, size_t count = (size_t)-1) { if (index < s.size()) s.erase(index, count); }
+  bool isEmpty() const { return s.empty(); }
+
+private:
+  static int found(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+  static std::string toBase(unsigned long v, int base)
+  {
+    if (base == 10) return std::to_string(v);
+    std::string r;
+    do { int d = v % base; r.insert(r.begin(), (char)(d < 10 ? '0' + d : 'a' + d - 10)); v /= base; } while (v);
+    return r;
+  }
+  static std::string toFixed(double v, unsigned int decimals)
+  {
+    char b[64];
+    snprintf(b, sizeof(b), "%.*f", decimals, v);
+    return b;
+  }
+  std::string s;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, int b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, uint16_t b) { String r(a); r += (unsigned)b; return r; }
+inline String operator+(const String& a, long b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned long b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, float b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, double b) { String r(a); r += b; return r; }
+
+class Printable;
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char v, int base = 10) { return print(String(v, base)); }
+  size_t print(int v, int base = 10) { return print(String(v, base)); }
+  size_t print(unsigned v, int base = 10) { return print(String(v, base)); }
+  size_t print(long v, int base = 10) { return print(String(v, base)); }
+  size_t print(unsigned long v, int base = 10) { return print(String(v, base)); }
+  size_t print(double v, int decimals = 2) { return print(String(v, (unsigned int)decimals)); }
+  size_t print(const Printable& p);
+  template<typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  template<typename T> size_t println(const T& v, int f) { size_t n = print(v, f); return n + println(); }
+  size_t println() { return print("\r\n"); }
+  size_t printf(const char* format, ...)
+  {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t*)buffer, std::min((size_t)n, sizeof(buffer) - 1)) : 0;
+  }
+  virtual void flush() {}
+};
+
+class Printable
+{
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+inline size_t Print::print(const Printable& p) { return p.printTo(*this); }
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { this->_timeout = timeout; }
+  size_t readBytes(char* buffer, size_t length)
+  {
+    size_t i = 0;
+    while (i < length)
+    {
+      int c = read();
+      if (c < 0) break;
+      buffer[i++] = (char)c;
+    }
+    return i;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+protected:
+  unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void setDebugOutput(bool) {}
+  void begin(unsigned long) {}
+};
+extern HardwareSerial Serial;
+
+#include <IPAddress.h>
+
+class EspClass
+{
+public:
+  // -- Restart is only counted, the test decides what happens next.
+  void restart() { this->restartCount++; }
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getFreeSketchSpace() { return 1966080; }
+  uint32_t getSketchSize() { return 1000000; }
+  void deepSleep(uint64_t) {}
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+
+  int restartCount = 0;
+  uint32_t rtcMemory[128] = { 0 };
+};
+extern EspClass ESP;
+
+#endif
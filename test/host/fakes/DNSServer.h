@@ -0,0 +1,45 @@
+/**
+ * DNSServer.h -- Host stand-in of DNSServer for the IotWebConf host tests.
+ *   Requests are only counted.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostDNSServer_h
+#define HostDNSServer_h
+
+#include <WiFi.h>
+
+enum class DNSReplyCode
+{
+  NoError = 0,
+  FormError = 1,
+  ServerFailure = 2,
+  NonExistentDomain = 3
+};
+
+class DNSServer
+{
+public:
+  void processNextRequest() { this->processCount++; }
+  void setErrorReplyCode(const DNSReplyCode& replyCode) { this->replyCode = replyCode; }
+  bool start(const uint16_t& port, const String& domainName, const IPAddress& resolvedIP)
+  {
+    this->running = true;
+    this->port = port;
+    this->resolvedIP = resolvedIP;
+    return true;
+  }
+  void stop() { this->running = false; }
+
+  bool running = false;
+  uint16_t port = 0;
+  IPAddress resolvedIP;
+  DNSReplyCode replyCode = DNSReplyCode::NonExistentDomain;
+  unsigned long processCount = 0;
+};
+
+#endif
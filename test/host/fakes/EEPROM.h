@@ -0,0 +1,56 @@
+/**
+ * EEPROM.h -- Host stand-in of the EEPROM library for the IotWebConf host
+ *   tests. The content is kept in RAM, so it survives a simulated reboot.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostEEPROM_h
+#define HostEEPROM_h
+
+#include <Arduino.h>
+
+class EEPROMClass
+{
+public:
+  static const size_t Capacity = 4096;
+
+  void begin(size_t size)
+  {
+    this->size = size < Capacity ? size : Capacity;
+    this->beginCount++;
+    host::advanceMicros(this->beginMicros);
+  }
+  uint8_t read(int address)
+  {
+    host::advanceMicros(this->readMicros);
+    return ((size_t)address < this->size) ? this->data[address] : 0;
+  }
+  void write(int address, uint8_t value)
+  {
+    if ((size_t)address < this->size)
+    {
+      this->data[address] = value;
+      this->dirty = true;
+    }
+  }
+  bool commit() { this->commitCount += this->dirty ? 1 : 0; this->dirty = false; return true; }
+  bool end() { this->commit(); this->size = 0; return true; }
+  // -- Erased state (as a fresh device).
+  void erase() { memset(this->data, 0xFF, Capacity); this->beginMicros = 0; this->readMicros = 0; }
+
+  uint8_t data[Capacity];
+  size_t size = 0;
+  bool dirty = false;
+  int beginCount = 0;
+  int commitCount = 0;
+  // -- Simulated cost of begin() (loading the flash sector) and of a read.
+  uint64_t beginMicros = 0;
+  uint64_t readMicros = 0;
+};
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * ESPmDNS.h -- Host stand-in of the ESP32 mDNS responder for the IotWebConf
+ *   host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostESPmDNS_h
+#define HostESPmDNS_h
+
+#include <Arduino.h>
+
+class MDNSResponder
+{
+public:
+  bool begin(const char*) { this->running = true; return true; }
+  void end() { this->running = false; }
+  bool addService(const char*, const char*, uint16_t) { return true; }
+  int queryService(const char*, const char*) { return 0; }
+  bool running = false;
+};
+extern MDNSResponder MDNS;
+
+#endif
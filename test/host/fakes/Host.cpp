@@ -0,0 +1,28 @@
+/**
+ * Host.cpp -- Resets the simulated environment of the IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Update.h>
+#include <WiFi.h>
+
+namespace host
+{
+
+void resetEnvironment()
+{
+  resetClock();
+  WiFi.reset();
+  EEPROM.erase();
+  EEPROM.size = 0;
+  Update.reset();
+  ESP.restartCount = 0;
+}
+
+} // end namespace
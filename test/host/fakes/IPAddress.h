@@ -0,0 +1,63 @@
+/**
+ * IPAddress.h -- Host stand-in of the Arduino IPAddress for the IotWebConf
+ *   host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostIPAddress_h
+#define HostIPAddress_h
+
+#include <Arduino.h>
+
+class IPAddress : public Printable
+{
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+  {
+    this->_bytes[0] = a;
+    this->_bytes[1] = b;
+    this->_bytes[2] = c;
+    this->_bytes[3] = d;
+  }
+  IPAddress(uint32_t address) { memcpy(this->_bytes, &address, 4); }
+  operator uint32_t() const
+  {
+    uint32_t address;
+    memcpy(&address, this->_bytes, 4);
+    return address;
+  }
+  uint8_t operator[](int i) const { return this->_bytes[i]; }
+  uint8_t& operator[](int i) { return this->_bytes[i]; }
+  bool operator==(const IPAddress& o) const { return memcmp(this->_bytes, o._bytes, 4) == 0; }
+
+  bool fromString(const String& address)
+  {
+    unsigned int a, b, c, d;
+    char rest;
+    if ((sscanf(address.c_str(), "%u.%u.%u.%u%c", &a, &b, &c, &d, &rest) != 4) ||
+      (a > 255) || (b > 255) || (c > 255) || (d > 255))
+    {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+  String toString() const
+  {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u",
+      this->_bytes[0], this->_bytes[1], this->_bytes[2], this->_bytes[3]);
+    return String(buffer);
+  }
+  size_t printTo(Print& p) const override { return p.print(this->toString()); }
+
+private:
+  uint8_t _bytes[4] = { 0, 0, 0, 0 };
+};
+
+#endif
@@ -0,0 +1,32 @@
+/**
+ * StreamString.h -- Host stand-in of StreamString for the IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostStreamString_h
+#define HostStreamString_h
+
+#include <Arduino.h>
+
+class StreamString : public Stream, public String
+{
+public:
+  size_t write(uint8_t c) override { this->concat((const char*)&c, 1); return 1; }
+  size_t write(const uint8_t* buffer, size_t size) override
+    { this->concat((const char*)buffer, size); return size; }
+  using Print::write;
+  int available() override { return this->length() - this->_position; }
+  int read() override
+    { return this->_position < this->length() ? (uint8_t)this->charAt(this->_position++) : -1; }
+  int peek() override
+    { return this->_position < this->length() ? (uint8_t)this->charAt(this->_position) : -1; }
+
+private:
+  size_t _position = 0;
+};
+
+#endif
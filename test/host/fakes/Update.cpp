@@ -0,0 +1,95 @@
+/**
+ * Update.cpp -- Host stand-in of the ESP32 Update library for the
+ *   IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <Update.h>
+
+UpdateClass Update;
+
+bool UpdateClass::begin(size_t size, int command)
+{
+  this->calls.push_back("begin");
+  if (this->running)
+  {
+    this->error = "Already running";
+    return false;
+  }
+  if (this->failBegin)
+  {
+    this->error = "Not Enough Space";
+    return false;
+  }
+  this->error = String();
+  this->image.clear();
+  this->written = 0;
+  this->expectedSize = size;
+  this->running = true;
+  this->activated = false;
+  return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t length)
+{
+  if (!this->running || this->hasError())
+  {
+    return 0;
+  }
+  if ((this->failWriteAt > 0) && (this->written + length >= this->failWriteAt))
+  {
+    this->error = "Flash Write Failed";
+    return 0;
+  }
+  if ((this->expectedSize != UPDATE_SIZE_UNKNOWN) &&
+    (this->written + length > this->expectedSize))
+  {
+    this->error = "Bad Size Given";
+    return 0;
+  }
+  if (this->keepImage)
+  {
+    this->image.insert(this->image.end(), data, data + length);
+  }
+  this->written += length;
+  return length;
+}
+
+bool UpdateClass::end(bool evenIfRemaining)
+{
+  this->calls.push_back("end");
+  if (!this->running)
+  {
+    if (!this->hasError())
+    {
+      this->error = "Update not running";
+    }
+    return false;
+  }
+  this->running = false;
+  if (this->hasError())
+  {
+    return false;
+  }
+  // -- With an unknown size the whole partition is expected, as on the
+  // ESP32. Incomplete image is discarded.
+  if (!evenIfRemaining &&
+    ((this->expectedSize == UPDATE_SIZE_UNKNOWN) || (this->written != this->expectedSize)))
+  {
+    this->error = "Aborted";
+    return false;
+  }
+  this->activated = (this->written > 0);
+  return this->activated;
+}
+
+void UpdateClass::abort()
+{
+  this->calls.push_back("abort");
+  this->running = false;
+  this->error = "Aborted";
+}
@@ -0,0 +1,55 @@
+/**
+ * Update.h -- Host stand-in of the ESP32 Update library for the IotWebConf
+ *   host tests. The image is collected in RAM.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostUpdate_h
+#define HostUpdate_h
+
+#include <Arduino.h>
+#include <vector>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+
+class UpdateClass
+{
+public:
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH);
+  size_t write(uint8_t* data, size_t length);
+  bool end(bool evenIfRemaining = false);
+  void abort();
+  bool hasError() { return this->error.length() > 0; }
+  void printError(Print& out) { out.println(this->error); }
+  bool isRunning() { return this->running; }
+  size_t progress() { return this->image.size(); }
+  size_t size() { return this->expectedSize; }
+  bool setMD5(const char*) { return true; }
+  void reset() { *this = UpdateClass(); }
+
+  /**
+   * Observation and fault injection.
+   */
+  std::vector<uint8_t> image;
+  // -- Written in the order of calls, e.g. "begin", "abort", "end".
+  std::vector<String> calls;
+  bool running = false;
+  // -- Activated image (end() succeeded).
+  bool activated = false;
+  String error;
+  size_t expectedSize = 0;
+  // -- Fails begin(), or the write reaching this many bytes (0: never).
+  bool failBegin = false;
+  size_t failWriteAt = 0;
+  // -- Only the size is kept, when false (benchmarks).
+  bool keepImage = true;
+  size_t written = 0;
+};
+extern UpdateClass Update;
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * WebServer.cpp -- Host stand-in of the ESP32 WebServer for the IotWebConf
+ *   host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <WebServer.h>
+
+void WebServer::on(
+  const String& uri, HTTPMethod method, THandlerFunction handler,
+  THandlerFunction uploadHandler)
+{
+  Route route;
+  route.uri = uri;
+  route.method = method;
+  route.handler = handler;
+  route.uploadHandler = uploadHandler;
+  this->_routes.push_back(route);
+}
+
+WebServer::Route* WebServer::findRoute(HTTPMethod method, const char* uri)
+{
+  // -- As with the original, the first matching handler wins.
+  for (Route& route : this->_routes)
+  {
+    if (route.uri.equals(uri) &&
+      ((route.method == HTTP_ANY) || (route.method == method)))
+    {
+      return &route;
+    }
+  }
+  return nullptr;
+}
+
+void WebServer::startRequest(
+  HTTPMethod method, const char* uri, const Args& args, const char* host)
+{
+  this->_method = method;
+  this->_uri = uri;
+  this->_args = args;
+  this->_host = host;
+  this->_response = Response();
+  // -- Requests for other hosts reach us through the captive portal DNS,
+  // that is on the AP address.
+  IPAddress local;
+  if (!local.fromString(host))
+  {
+    local = WiFi.softAPIP();
+  }
+  this->_client.setLocal(local, this->_port);
+}
+
+const WebServer::Response& WebServer::request(
+  HTTPMethod method, const char* uri, const Args& args, const char* host)
+{
+  this->startRequest(method, uri, args, host);
+  Route* route = this->findRoute(method, uri);
+  if (route != nullptr)
+  {
+    route->handler();
+  }
+  else if (this->_notFoundHandler != nullptr)
+  {
+    this->_notFoundHandler();
+  }
+  else
+  {
+    this->send(404, "text/plain", "Not found: " + this->_uri);
+  }
+  return this->_response;
+}
+
+const WebServer::Response& WebServer::upload(
+  const char* uri, const uint8_t* data, size_t length,
+  const Args& args, size_t abortAfter)
+{
+  this->startRequest(HTTP_POST, uri, args, "192.168.4.1");
+  Route* route = this->findRoute(HTTP_POST, uri);
+  if ((route == nullptr) || (route->uploadHandler == nullptr))
+  {
+    this->send(404, "text/plain", "Not found: " + this->_uri);
+    return this->_response;
+  }
+
+  this->_upload.filename = "firmware.bin";
+  this->_upload.name = "update";
+  this->_upload.type = "application/octet-stream";
+  this->_upload.totalSize = 0;
+  this->_upload.currentSize = 0;
+  this->_upload.status = UPLOAD_FILE_START;
+  route->uploadHandler();
+
+  size_t position = 0;
+  while (position < length)
+  {
+    size_t size = std::min(length - position, (size_t)HTTP_UPLOAD_BUFLEN);
+    if ((abortAfter > 0) && (position + size > abortAfter))
+    {
+      this->_upload.status = UPLOAD_FILE_ABORTED;
+      route->uploadHandler();
+      // -- Connection is lost, no response is sent.
+      this->_response = Response();
+      return this->_response;
+    }
+    memcpy(this->_upload.buf, data + position, size);
+    this->_upload.currentSize = size;
+    this->_upload.totalSize += size;
+    this->_upload.status = UPLOAD_FILE_WRITE;
+    route->uploadHandler();
+    position += size;
+  }
+
+  this->_upload.currentSize = 0;
+  this->_upload.status = UPLOAD_FILE_END;
+  route->uploadHandler();
+  route->handler();
+  return this->_response;
+}
+
+bool WebServer::authenticate(const char* user, const char* password)
+{
+  return this->_clientUser.equals(user) && this->_clientPassword.equals(password);
+}
+
+void WebServer::requestAuthentication()
+{
+  this->_response.authenticationRequested = true;
+  this->send(401, "text/html", "Unauthorized");
+}
+
+bool WebServer::hasArg(const String& name)
+{
+  for (const auto& arg : this->_args)
+  {
+    if (arg.first == name)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+String WebServer::arg(const String& name)
+{
+  for (const auto& arg : this->_args)
+  {
+    if (arg.first == name)
+    {
+      return arg.second;
+    }
+  }
+  return String();
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first)
+{
+  if (first)
+  {
+    this->_response.headers.insert(this->_response.headers.begin(), { name, value });
+  }
+  else
+  {
+    this->_response.headers.push_back({ name, value });
+  }
+}
+
+void WebServer::send(int code, const char* contentType, const String& content)
+{
+  this->_response.code = code;
+  this->_response.contentType = contentType == nullptr ? "" : contentType;
+  this->_response.content = content;
+}
@@ -0,0 +1,151 @@
+/**
+ * WebServer.h -- Host stand-in of the ESP32 WebServer for the IotWebConf
+ *   host tests. There is no network behind it: the test plays the client
+ *   with request() and upload(), and reads the captured response.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostWebServer_h
+#define HostWebServer_h
+
+#include <WiFi.h>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 1436
+
+struct HTTPUpload
+{
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+class WebServer
+{
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::vector<std::pair<String, String>> Args;
+
+  // -- Response of the last request.
+  struct Response
+  {
+    int code = 0;
+    String contentType;
+    String content;
+    std::vector<std::pair<String, String>> headers;
+    bool authenticationRequested = false;
+    String header(const char* name) const
+    {
+      for (const auto& h : this->headers)
+      {
+        if (h.first.equalsIgnoreCase(name))
+        {
+          return h.second;
+        }
+      }
+      return String();
+    }
+  };
+
+  WebServer(int port = 80) : _port(port) {}
+
+  /**
+   * Client side of the simulation.
+   */
+  // -- Calls the handler of the uri (or the not found handler), returns
+  // the response.
+  const Response& request(
+    HTTPMethod method, const char* uri, const Args& args = Args(),
+    const char* host = "192.168.4.1");
+  // -- Multipart upload of the data in HTTP_UPLOAD_BUFLEN pieces. The
+  // upload is aborted after abortAfter bytes (if not 0), as when the
+  // connection is lost. Returns the response of the request handler (code
+  // is 0, when the upload was aborted).
+  const Response& upload(
+    const char* uri, const uint8_t* data, size_t length,
+    const Args& args = Args(), size_t abortAfter = 0);
+  // -- Basic authentication credentials sent with the following requests.
+  void setClientCredentials(const char* user, const char* password)
+  {
+    this->_clientUser = user;
+    this->_clientPassword = password;
+  }
+  const Response& response() const { return this->_response; }
+  bool begun() const { return this->_beginCount > 0; }
+  int handleClientCount = 0;
+
+  /**
+   * WebServer API.
+   */
+  void on(const String& uri, HTTPMethod method, THandlerFunction handler)
+    { this->on(uri, method, handler, nullptr); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler);
+  void on(const String& uri, THandlerFunction handler) { this->on(uri, HTTP_ANY, handler, nullptr); }
+  void onNotFound(THandlerFunction handler) { this->_notFoundHandler = handler; }
+  String hostHeader() { return this->_host; }
+  WiFiClient& client() { return this->_client; }
+  bool authenticate(const char* user, const char* password);
+  void requestAuthentication();
+  bool hasArg(const String& name);
+  String arg(const String& name);
+  String arg(int i) { return i < this->args() ? this->_args[i].second : String(); }
+  String argName(int i) { return i < this->args() ? this->_args[i].first : String(); }
+  int args() { return this->_args.size(); }
+  bool hasHeader(const String&) { return false; }
+  String header(const String&) { return String(); }
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {}
+  String uri() { return this->_uri; }
+  HTTPMethod method() { return this->_method; }
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t contentLength) {}
+  void send(int code, const char* contentType = nullptr, const String& content = String(""));
+  void send(int code, const String& contentType, const String& content)
+    { this->send(code, contentType.c_str(), content); }
+  void send_P(int code, const char* contentType, const char* content)
+    { this->send(code, contentType, String(content)); }
+  void sendContent(const String& content) { this->_response.content += content; }
+  void sendContent(const char* content, size_t length) { this->_response.content.concat(content, length); }
+  void sendContent_P(const char* content) { this->_response.content += content; }
+  void handleClient() { this->handleClientCount++; }
+  void begin() { this->_beginCount++; }
+  HTTPUpload& upload() { return this->_upload; }
+
+private:
+  struct Route
+  {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction handler;
+    THandlerFunction uploadHandler;
+  };
+  Route* findRoute(HTTPMethod method, const char* uri);
+  void startRequest(HTTPMethod method, const char* uri, const Args& args, const char* host);
+
+  int _port;
+  int _beginCount = 0;
+  std::vector<Route> _routes;
+  THandlerFunction _notFoundHandler;
+  WiFiClient _client;
+  HTTPUpload _upload;
+  Response _response;
+  HTTPMethod _method = HTTP_GET;
+  String _uri;
+  String _host;
+  Args _args;
+  String _clientUser;
+  String _clientPassword;
+};
+
+#endif
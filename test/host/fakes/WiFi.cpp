@@ -0,0 +1,419 @@
+/**
+ * WiFi.cpp -- Host stand-in of the ESP32 WiFi library for the IotWebConf
+ *   host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <WiFi.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+WiFiClass::Network* WiFiClass::addNetwork(
+  const char* ssid, const char* password, int32_t rssi,
+  int32_t channel, uint8_t bssidTail)
+{
+  Network network;
+  network.ssid = ssid;
+  network.password = password;
+  network.rssi = rssi;
+  network.channel = channel;
+  const uint8_t bssid[6] = { 0x02, 0x00, 0x00, 0x00, (uint8_t)this->_networks.size(), bssidTail };
+  memcpy(network.bssid, bssid, 6);
+  network.inRange = true;
+  this->_networks.push_back(network);
+  return &this->_networks.back();
+}
+
+WiFiClass::Network* WiFiClass::findNetwork(const char* ssid)
+{
+  for (Network& network : this->_networks)
+  {
+    if (network.ssid.equals(ssid))
+    {
+      return &network;
+    }
+  }
+  return nullptr;
+}
+
+void WiFiClass::setInRange(const char* ssid, bool inRange)
+{
+  for (Network& network : this->_networks)
+  {
+    if (network.ssid.equals(ssid))
+    {
+      network.inRange = inRange;
+    }
+  }
+}
+
+void WiFiClass::dropConnection()
+{
+  if (this->_target != nullptr)
+  {
+    this->_target->inRange = false;
+  }
+}
+
+void WiFiClass::reset()
+{
+  *this = WiFiClass();
+}
+
+wl_status_t WiFiClass::status()
+{
+  if (!this->_connecting)
+  {
+    return WL_DISCONNECTED;
+  }
+  if (this->_target == nullptr)
+  {
+    // -- As the real one, WiFi keeps trying in the background, until the
+    // network shows up.
+    this->_target = this->findTarget();
+    if (this->_target == nullptr)
+    {
+      return WL_DISCONNECTED;
+    }
+    this->_beginMs = millis();
+  }
+  if (!this->_target->inRange)
+  {
+    return WL_CONNECTION_LOST;
+  }
+  if (millis() - this->_beginMs < this->connectDelayMs)
+  {
+    return WL_DISCONNECTED;
+  }
+  return WL_CONNECTED;
+}
+
+WiFiClass::Network* WiFiClass::findTarget()
+{
+  for (Network& network : this->_networks)
+  {
+    if (network.inRange && network.ssid.equals(this->_beginSsid) &&
+      network.password.equals(this->_beginPassword) &&
+      (!this->_beginBssidSet || (memcmp(this->_beginBssid, network.bssid, 6) == 0)))
+    {
+      return &network;
+    }
+  }
+  return nullptr;
+}
+
+bool WiFiClass::disconnect(bool wifiOff)
+{
+  this->_connecting = false;
+  this->_target = nullptr;
+  if (wifiOff)
+  {
+    this->currentMode = WIFI_OFF;
+  }
+  return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password, int channel, int hidden, int maxConnections)
+{
+  this->apUp = true;
+  this->apSsid = ssid;
+  this->apPassword = password;
+  return true;
+}
+
+wl_status_t WiFiClass::begin(
+  const char* ssid, const char* password, int32_t channel,
+  const uint8_t* bssid, bool connect)
+{
+  this->beginCount++;
+  this->lastBeginSsid = ssid;
+  this->lastBeginChannel = channel;
+  this->_beginSsid = ssid;
+  this->_beginPassword = password == nullptr ? "" : password;
+  this->_beginBssidSet = (bssid != nullptr);
+  if (bssid != nullptr)
+  {
+    memcpy(this->_beginBssid, bssid, 6);
+  }
+  this->_connecting = true;
+  this->_beginMs = millis();
+  this->_target = this->findTarget();
+  return WL_DISCONNECTED;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden)
+{
+  this->scanCount++;
+  this->_scanResults.clear();
+  this->_scanFailed = this->failNextScan;
+  this->failNextScan = false;
+  for (const Network& network : this->_networks)
+  {
+    if (network.inRange)
+    {
+      this->_scanResults.push_back(network);
+    }
+  }
+  this->_scanning = true;
+  this->_scanStartMs = millis();
+  return async ? WIFI_SCAN_RUNNING : this->scanComplete();
+}
+
+int16_t WiFiClass::scanComplete()
+{
+  if (!this->_scanning)
+  {
+    return WIFI_SCAN_FAILED;
+  }
+  if (millis() - this->_scanStartMs < this->scanDurationMs)
+  {
+    return WIFI_SCAN_RUNNING;
+  }
+  return this->_scanFailed ? WIFI_SCAN_FAILED : this->_scanResults.size();
+}
+
+void WiFiClass::scanDelete()
+{
+  this->_scanning = false;
+  this->_scanResults.clear();
+}
+
+String WiFiClass::SSID(uint8_t i)
+{
+  return i < this->_scanResults.size() ? this->_scanResults[i].ssid : String();
+}
+
+String WiFiClass::SSID()
+{
+  return this->connectedNetwork() ? this->_target->ssid : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t i)
+{
+  return i < this->_scanResults.size() ? this->_scanResults[i].rssi : 0;
+}
+
+int32_t WiFiClass::RSSI()
+{
+  return this->connectedNetwork() ? this->_target->rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID(uint8_t i)
+{
+  return i < this->_scanResults.size() ? this->_scanResults[i].bssid : nullptr;
+}
+
+uint8_t* WiFiClass::BSSID()
+{
+  return this->connectedNetwork() ? this->_target->bssid : nullptr;
+}
+
+int32_t WiFiClass::channel(uint8_t i)
+{
+  return i < this->_scanResults.size() ? this->_scanResults[i].channel : 0;
+}
+
+int32_t WiFiClass::channel()
+{
+  return this->connectedNetwork() ? this->_target->channel : 0;
+}
+
+//////////////////////////////////////////////////////////////////
+
+int WiFiClient::connect(const char* host, uint16_t port)
+{
+  this->stop();
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* result;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &result) != 0)
+  {
+    return 0;
+  }
+  int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if ((fd < 0) || (::connect(fd, result->ai_addr, result->ai_addrlen) != 0))
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    freeaddrinfo(result);
+    return 0;
+  }
+  freeaddrinfo(result);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  this->_fd = fd;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size)
+{
+  size_t written = 0;
+  while ((this->_fd >= 0) && (written < size))
+  {
+    ssize_t n = send(this->_fd, buffer + written, size - written, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      written += n;
+    }
+    else if ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+    {
+      break;
+    }
+  }
+  return written;
+}
+
+int WiFiClient::available()
+{
+  if (this->_fd < 0)
+  {
+    return this->_peeked >= 0 ? 1 : 0;
+  }
+  int pending = 0;
+  ioctl(this->_fd, FIONREAD, &pending);
+  return pending + (this->_peeked >= 0 ? 1 : 0);
+}
+
+int WiFiClient::read()
+{
+  uint8_t c;
+  return this->read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size)
+{
+  if (size == 0)
+  {
+    return 0;
+  }
+  size_t offset = 0;
+  if (this->_peeked >= 0)
+  {
+    buffer[offset++] = this->_peeked;
+    this->_peeked = -1;
+  }
+  if ((this->_fd >= 0) && (offset < size))
+  {
+    ssize_t n = recv(this->_fd, buffer + offset, size - offset, MSG_DONTWAIT);
+    if (n > 0)
+    {
+      offset += n;
+    }
+  }
+  return offset > 0 ? (int)offset : -1;
+}
+
+int WiFiClient::peek()
+{
+  if (this->_peeked < 0)
+  {
+    this->_peeked = this->read();
+  }
+  return this->_peeked;
+}
+
+void WiFiClient::stop()
+{
+  if (this->_fd >= 0)
+  {
+    close(this->_fd);
+    this->_fd = -1;
+  }
+  this->_peeked = -1;
+}
+
+uint8_t WiFiClient::connected()
+{
+  if (this->_fd < 0)
+  {
+    return 0;
+  }
+  uint8_t c;
+  ssize_t n = recv(this->_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0)
+  {
+    return 1;
+  }
+  return ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) ? 1 : 0;
+}
+
+//////////////////////////////////////////////////////////////////
+
+void WiFiUDP::inject(const uint8_t* data, size_t length, IPAddress ip, uint16_t port)
+{
+  Packet packet;
+  packet.data.assign(data, data + length);
+  packet.ip = ip;
+  packet.port = port;
+  this->pendingPackets.push_back(packet);
+}
+
+int WiFiUDP::parsePacket()
+{
+  if ((this->boundPort == 0) || this->pendingPackets.empty())
+  {
+    return 0;
+  }
+  this->_current = this->pendingPackets.front();
+  this->pendingPackets.pop_front();
+  this->_position = 0;
+  return this->_current.data.size();
+}
+
+int WiFiUDP::read()
+{
+  return this->_position < this->_current.data.size() ?
+    this->_current.data[this->_position++] : -1;
+}
+
+int WiFiUDP::read(unsigned char* buffer, size_t length)
+{
+  size_t n = std::min(length, this->_current.data.size() - this->_position);
+  memcpy(buffer, this->_current.data.data() + this->_position, n);
+  this->_position += n;
+  return n;
+}
+
+int WiFiUDP::peek()
+{
+  return this->_position < this->_current.data.size() ?
+    this->_current.data[this->_position] : -1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size)
+{
+  this->_outgoing.data.insert(this->_outgoing.data.end(), buffer, buffer + size);
+  return size;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  this->_outgoing = Packet();
+  this->_outgoing.ip = ip;
+  this->_outgoing.port = port;
+  return 1;
+}
+
+int WiFiUDP::endPacket()
+{
+  this->sentPackets.push_back(this->_outgoing);
+  return 1;
+}
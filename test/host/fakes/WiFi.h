@@ -0,0 +1,213 @@
+/**
+ * WiFi.h -- Host stand-in of the ESP32 WiFi library for the IotWebConf
+ *   host tests. WiFi is a scriptable simulation on the virtual clock,
+ *   WiFiClient is a real (POSIX) TCP client, WiFiUDP is a packet queue.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostWiFi_h
+#define HostWiFi_h
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <deque>
+#include <vector>
+
+typedef enum
+{
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass
+{
+public:
+  // -- A simulated access point.
+  struct Network
+  {
+    String ssid;
+    String password;
+    int32_t rssi;
+    int32_t channel;
+    uint8_t bssid[6];
+    bool inRange;
+  };
+
+  /**
+   * Scripting of the simulation.
+   */
+  // -- Adds an access point. Networks with the same SSID are separate
+  // access points of the same network (distinguished by bssidTail).
+  Network* addNetwork(
+    const char* ssid, const char* password, int32_t rssi = -60,
+    int32_t channel = 1, uint8_t bssidTail = 1);
+  Network* findNetwork(const char* ssid);
+  void setInRange(const char* ssid, bool inRange);
+  // -- The access point we are connected to goes away.
+  void dropConnection();
+  void reset();
+  // -- Time from begin() until the connection is established.
+  unsigned long connectDelayMs = 2000;
+  // -- Time from scanNetworks() until the results are ready.
+  unsigned long scanDurationMs = 1500;
+  // -- The next scan fails (WIFI_SCAN_FAILED).
+  bool failNextScan = false;
+  // -- Number of stations joined to our AP.
+  uint8_t stationNum = 0;
+
+  /**
+   * Observation of the simulation.
+   */
+  wifi_mode_t currentMode = WIFI_OFF;
+  bool apUp = false;
+  String apSsid;
+  String apPassword;
+  int beginCount = 0;
+  int scanCount = 0;
+  String lastBeginSsid;
+  int32_t lastBeginChannel = 0;
+  const Network* connectedNetwork() { return this->status() == WL_CONNECTED ? this->_target : nullptr; }
+
+  /**
+   * WiFi API.
+   */
+  wl_status_t status();
+  bool mode(wifi_mode_t mode) { this->currentMode = mode; return true; }
+  wifi_mode_t getMode() { return this->currentMode; }
+  bool disconnect(bool wifiOff = false);
+  bool softAPdisconnect(bool wifiOff = false) { this->apUp = false; return true; }
+  bool softAP(const char* ssid, const char* password, int channel = 1, int hidden = 0, int maxConnections = 4);
+  uint8_t softAPgetStationNum() { return this->apUp ? this->stationNum : 0; }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  IPAddress localIP() { return this->status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+  IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+  IPAddress dnsIP(uint8_t = 0) { return IPAddress(192, 168, 1, 1); }
+  bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+  wl_status_t begin(
+    const char* ssid, const char* password = nullptr, int32_t channel = 0,
+    const uint8_t* bssid = nullptr, bool connect = true);
+  bool setHostname(const char*) { return true; }
+  bool hostname(const char*) { return true; }
+  int16_t scanNetworks(bool async = false, bool showHidden = false);
+  int16_t scanComplete();
+  void scanDelete();
+  String SSID(uint8_t i);
+  String SSID();
+  int32_t RSSI(uint8_t i);
+  int32_t RSSI();
+  uint8_t* BSSID(uint8_t i);
+  uint8_t* BSSID();
+  int32_t channel(uint8_t i);
+  int32_t channel();
+
+private:
+  std::deque<Network> _networks;
+  std::vector<Network> _scanResults;
+  bool _scanning = false;
+  bool _scanFailed = false;
+  unsigned long _scanStartMs = 0;
+  Network* findTarget();
+  Network* _target = nullptr;
+  bool _connecting = false;
+  String _beginSsid;
+  String _beginPassword;
+  uint8_t _beginBssid[6];
+  bool _beginBssidSet = false;
+  unsigned long _beginMs = 0;
+};
+extern WiFiClass WiFi;
+
+/**
+ * TCP client over POSIX sockets. Connecting is blocking, everything else
+ * is non-blocking, as with the ESP32 implementation.
+ */
+class WiFiClient : public Stream
+{
+public:
+  WiFiClient() {}
+  ~WiFiClient() { this->stop(); }
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+
+  int connect(const char* host, uint16_t port);
+  int connect(IPAddress ip, uint16_t port) { return this->connect(ip.toString().c_str(), port); }
+  size_t write(uint8_t c) override { return this->write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buffer, size_t size);
+  int peek() override;
+  void stop();
+  uint8_t connected();
+  operator bool() { return this->_fd >= 0; }
+  void setNoDelay(bool) {}
+  IPAddress localIP() { return this->_localIp; }
+  uint16_t localPort() { return this->_localPort; }
+  // -- Local end as seen by a web server request.
+  void setLocal(const IPAddress& ip, uint16_t port) { this->_localIp = ip; this->_localPort = port; }
+
+private:
+  int _fd = -1;
+  int _peeked = -1;
+  IPAddress _localIp;
+  uint16_t _localPort = 80;
+};
+
+/**
+ * UDP socket simulation: packets are injected by the test, replies are
+ * collected in sentPackets.
+ */
+class WiFiUDP : public Stream
+{
+public:
+  struct Packet
+  {
+    std::vector<uint8_t> data;
+    IPAddress ip;
+    uint16_t port;
+  };
+
+  void inject(const uint8_t* data, size_t length, IPAddress ip, uint16_t port);
+  std::deque<Packet> pendingPackets;
+  std::vector<Packet> sentPackets;
+  uint16_t boundPort = 0;
+
+  uint8_t begin(uint16_t port) { this->boundPort = port; return 1; }
+  void stop() { this->boundPort = 0; }
+  int parsePacket();
+  int read() override;
+  int read(unsigned char* buffer, size_t length);
+  int read(char* buffer, size_t length) { return this->read((unsigned char*)buffer, length); }
+  int available() override { return this->_current.data.size() - this->_position; }
+  int peek() override;
+  size_t write(uint8_t c) override { return this->write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int beginPacket(IPAddress ip, uint16_t port);
+  int endPacket();
+  IPAddress remoteIP() { return this->_current.ip; }
+  uint16_t remotePort() { return this->_current.port; }
+
+private:
+  Packet _current;
+  size_t _position = 0;
+  Packet _outgoing;
+};
+
+#endif
@@ -0,0 +1,10 @@
+/**
+ * WiFiClient.h -- Host stand-in for the IotWebConf host tests, see WiFi.h.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <WiFi.h>
@@ -0,0 +1,30 @@
+/**
+ * mbedtls/sha256.h -- SHA-256 with the mbedtls API for the IotWebConf host tests.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostMbedtlsSha256_h
+#define HostMbedtlsSha256_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t state[8];
+  uint64_t length;
+  unsigned char buffer[64];
+  size_t bufferLength;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+int mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t length);
+int mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]);
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * miniz.cpp -- tinfl_decompress() of the ESP32 ROM for the IotWebConf host
+ *   tests, implemented with zlib raw inflate.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <rom/miniz.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+namespace
+{
+// -- m_state values.
+const mz_uint32 StateNew = 0;
+const mz_uint32 StateInflating = 1;
+const mz_uint32 StateFinished = 2;
+const mz_uint32 StateFailed = 3;
+
+void release(tinfl_decompressor* r)
+{
+  z_stream* stream = (z_stream*)r->m_stream;
+  if (stream != nullptr)
+  {
+    inflateEnd(stream);
+    free(stream);
+    r->m_stream = nullptr;
+  }
+}
+} // end anonymous namespace
+
+tinfl_status tinfl_decompress(
+  tinfl_decompressor* r, const mz_uint8* pIn_buf_next, size_t* pIn_buf_size,
+  mz_uint8* pOut_buf_start, mz_uint8* pOut_buf_next, size_t* pOut_buf_size,
+  const mz_uint32 decomp_flags)
+{
+  if (r->m_state == StateFinished)
+  {
+    *pIn_buf_size = 0;
+    *pOut_buf_size = 0;
+    return TINFL_STATUS_DONE;
+  }
+  if (r->m_state == StateFailed)
+  {
+    *pIn_buf_size = 0;
+    *pOut_buf_size = 0;
+    return TINFL_STATUS_FAILED;
+  }
+  if (r->m_state == StateNew)
+  {
+    z_stream* stream = (z_stream*)calloc(1, sizeof(z_stream));
+    int windowBits = (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? 15 : -15;
+    if ((stream == nullptr) || (inflateInit2(stream, windowBits) != Z_OK))
+    {
+      free(stream);
+      return TINFL_STATUS_FAILED;
+    }
+    r->m_stream = stream;
+    r->m_state = StateInflating;
+  }
+
+  z_stream* stream = (z_stream*)r->m_stream;
+  stream->next_in = (Bytef*)pIn_buf_next;
+  stream->avail_in = *pIn_buf_size;
+  stream->next_out = pOut_buf_next;
+  stream->avail_out = *pOut_buf_size;
+  int result = inflate(stream, Z_NO_FLUSH);
+  *pIn_buf_size -= stream->avail_in;
+  *pOut_buf_size -= stream->avail_out;
+
+  if (result == Z_STREAM_END)
+  {
+    release(r);
+    r->m_state = StateFinished;
+    return TINFL_STATUS_DONE;
+  }
+  if ((result != Z_OK) && (result != Z_BUF_ERROR))
+  {
+    release(r);
+    r->m_state = StateFailed;
+    return TINFL_STATUS_FAILED;
+  }
+  if (stream->avail_out == 0)
+  {
+    return TINFL_STATUS_HAS_MORE_OUTPUT;
+  }
+  return (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT) ?
+    TINFL_STATUS_NEEDS_MORE_INPUT : TINFL_STATUS_FAILED;
+}
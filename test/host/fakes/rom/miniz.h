@@ -0,0 +1,56 @@
+/**
+ * rom/miniz.h -- tinfl API of the ESP32 ROM for the IotWebConf host tests,
+ *   implemented with zlib.
+ *
+ * Copyright (C) 2021 Balazs Kelemen <prampec+arduino@gmail.com>
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef HostMiniz_h
+#define HostMiniz_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t mz_uint8;
+typedef uint32_t mz_uint32;
+
+enum
+{
+  TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+  TINFL_FLAG_HAS_MORE_INPUT = 2,
+  TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+  TINFL_FLAG_COMPUTE_ADLER32 = 8
+};
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+typedef enum
+{
+  TINFL_STATUS_BAD_PARAM = -3,
+  TINFL_STATUS_ADLER32_MISMATCH = -2,
+  TINFL_STATUS_FAILED = -1,
+  TINFL_STATUS_DONE = 0,
+  TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+  TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+// -- Plain data, as the decompressor is allocated with malloc(). The zlib
+// stream is set up by the first tinfl_decompress() call after tinfl_init(),
+// and released when the stream is done or failed.
+typedef struct
+{
+  mz_uint32 m_state;
+  void* m_stream;
+} tinfl_decompressor;
+
+#define tinfl_init(r) do { (r)->m_state = 0; (r)->m_stream = nullptr; } while (0)
+
+tinfl_status tinfl_decompress(
+  tinfl_decompressor* r, const mz_uint8* pIn_buf_next, size_t* pIn_buf_size,
+  mz_uint8* pOut_buf_start, mz_uint8* pOut_buf_next, size_t* pOut_buf_size,
+  const mz_uint32 decomp_flags);
+
+#endif